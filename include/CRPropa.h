@@ -5,6 +5,8 @@
 #include "crpropa/Candidate.h"
 #include "crpropa/Common.h"
 #include "crpropa/Cosmology.h"
+#include "crpropa/CpuFeatures.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/EmissionMap.h"
 #include "crpropa/Geometry.h"
 #include "crpropa/Grid.h"
@@ -19,6 +21,7 @@
 #include "crpropa/Random.h"
 #include "crpropa/Referenced.h"
 #include "crpropa/Source.h"
+#include "crpropa/Symbol.h"
 #include "crpropa/Units.h"
 #include "crpropa/Variant.h"
 #include "crpropa/Vector3.h"
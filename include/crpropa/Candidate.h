@@ -5,6 +5,7 @@
 #include "crpropa/Referenced.h"
 #include "crpropa/AssocVector.h"
 #include "crpropa/Variant.h"
+#include "crpropa/Symbol.h"
 
 #include <vector>
 #include <map>
@@ -12,6 +13,8 @@
 #include <stdint.h>
 
 namespace crpropa {
+
+class MagneticField;
 /**
  * \addtogroup Core
  * @{
@@ -33,7 +36,7 @@ public:
 
 	std::vector<ref_ptr<Candidate> > secondaries; /**< Secondary particles from interactions */
 
-	typedef Loki::AssocVector<std::string, Variant> PropertyMap;
+	typedef Loki::AssocVector<Symbol, Variant> PropertyMap;
 	PropertyMap properties; /**< Map of property names and their values. */
 
 	/** Parent candidate. 0 if no parent (initial particle). Must not be a ref_ptr to prevent circular referencing. */
@@ -46,12 +49,19 @@ private:
 	double trajectoryLength; /**< Comoving distance [m] the candidate has traveled so far */
 	double currentStep; /**< Size of the currently performed step in [m] comoving units */
 	double nextStep; /**< Proposed size of the next propagation step in [m] comoving units */
-	std::string tagOrigin; /**< Name of interaction/source process which created this candidate*/
+	Symbol tagOrigin; /**< Name of interaction/source process which created this candidate*/
 	double time; /**< Time [s] that has passed in the laboratory frame of reference */
 
 	static uint64_t nextSerialNumber;
+	static uint64_t serialNumberBlockSize;
+	static uint64_t serialNumberGeneration;
 	uint64_t serialNumber;
 
+	const MagneticField *cachedField; /**< Field of the last getMagneticField call */
+	Vector3d cachedFieldPosition;
+	double cachedFieldRedshift;
+	Vector3d cachedFieldValue;
+
 public:
 	Candidate(
 		int id = 0,
@@ -106,7 +116,9 @@ public:
 	 Sets the tagOrigin of the candidate. Can be used to trace back the interactions
 	 */
 	void setTagOrigin(std::string tagOrigin);
-	std::string getTagOrigin() const;
+	void setTagOrigin(const Symbol &tagOrigin);
+	const std::string &getTagOrigin() const;
+	const Symbol &getTagSymbol() const;
 
 	/**
 	 Sets the time of the candidate.
@@ -119,11 +131,29 @@ public:
 	 */
 	void limitNextStep(double step);
 
+	/**
+	 Magnetic field at the given position, cached per candidate.
+	 Modules evaluating the same field at the same point within one step
+	 (e.g. the propagation and the synchrotron radiation at the current
+	 position) share a single field evaluation.
+	 The cache holds one value and is valid for identical field, position and redshift only.
+	 @param field		magnetic field to evaluate
+	 @param position	position [m]
+	 @param z			redshift
+	 */
+	Vector3d getMagneticField(const MagneticField *field, const Vector3d &position, double z);
+
 	void setProperty(const std::string &name, const Variant &value);
 	const Variant &getProperty(const std::string &name) const;
 	bool removeProperty(const std::string &name);
 	bool hasProperty(const std::string &name) const;
 
+	/** Property access by interned name, without a string lookup */
+	void setProperty(const Symbol &name, const Variant &value);
+	const Variant &getProperty(const Symbol &name) const;
+	bool removeProperty(const Symbol &name);
+	bool hasProperty(const Symbol &name) const;
+
 	/**
 	 Add a new candidate to the list of secondaries.
 	 @param c Candidate
@@ -152,6 +182,9 @@ public:
 	 @param tagOrigin 	tag of the secondary
 	 */
 	void addSecondary(int id, double energy, Vector3d position, double w = 1., std::string tagOrigin = "SEC");
+	/** Add a new candidate to the list of secondaries, with interned tag. */
+	void addSecondary(int id, double energy, double w, const Symbol &tagOrigin);
+	void addSecondary(int id, double energy, Vector3d position, double w, const Symbol &tagOrigin);
 	void clearSecondaries();
 
 	std::string getDescription() const;
@@ -169,9 +202,21 @@ public:
 	/** Set the next serial number to use */
 	static void setNextSerialNumber(uint64_t snr);
 
-	/** Get the next serial number that will be assigned */
+	/** Get the first serial number not reserved by any thread (see setSerialNumberBlockSize) */
 	static uint64_t getNextSerialNumber();
 
+	/** Take a new unique serial number, as done by the constructors */
+	static uint64_t allocateSerialNumber();
+
+	/**
+	 Set the number of serial numbers each thread reserves at once.
+	 Larger blocks avoid the contention of the shared counter when many
+	 candidates are created in parallel. Serial numbers are still unique,
+	 but not consecutive across threads. The block size is stored in the output files.
+	 */
+	static void setSerialNumberBlockSize(uint64_t size);
+	static uint64_t getSerialNumberBlockSize();
+
 	/**
 	 Create an exact clone of candidate
 	 @param recursive	recursively clone and add the secondaries
@@ -183,6 +228,15 @@ public:
 	 and activate it if inactive, e.g. restart it
 	*/
 	void restart();
+
+	/**
+	 Candidates are allocated from a per-thread pool of freed candidates,
+	 to avoid the contention of the global heap in cascades with many secondaries.
+	 Each thread keeps at most maxPoolSize freed candidates.
+	 */
+	static void *operator new(size_t size);
+	static void operator delete(void *p, size_t size);
+	static const size_t maxPoolSize = 4096;
 };
 
 /** @}*/
@@ -0,0 +1,53 @@
+#ifndef CRPROPA_CPUFEATURES_H
+#define CRPROPA_CPUFEATURES_H
+
+/**
+ @file
+ @brief Runtime detection of the SIMD instruction sets supported by the CPU
+
+ With GCC and Clang on x86, SIMD kernels are compiled for several instruction
+ sets using CRPROPA_TARGET and the fastest one supported by the CPU is selected
+ at runtime, so that one binary runs on all CPUs. With other compilers only
+ the instruction sets enabled at compile time are used.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRPROPA_HAVE_TARGET_DISPATCH
+#define CRPROPA_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CRPROPA_TARGET(isa)
+#endif
+
+namespace crpropa {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/** SIMD instruction sets, each including the previous ones */
+enum SimdLevel {
+	SIMD_NONE = 0,
+	SIMD_SSE42,
+	SIMD_AVX,
+	SIMD_AVX2_FMA,
+	SIMD_AVX512
+};
+
+/** Highest SIMD level supported by the CPU (and the operating system) */
+SimdLevel cpuSimdLevel();
+
+/** Limit the SIMD level used by kernels selected afterwards, e.g. to reproduce
+ results of the scalar implementations. Default: SIMD_AVX512 (no limit) */
+void setMaximumSimdLevel(SimdLevel level);
+SimdLevel getMaximumSimdLevel();
+
+/** SIMD level to be used: the lower of cpuSimdLevel and getMaximumSimdLevel */
+SimdLevel getSimdLevel();
+
+/** Name of a SIMD level, e.g. "AVX2+FMA" */
+const char *simdLevelName(SimdLevel level);
+
+/** @}*/
+} // namespace crpropa
+
+#endif // CRPROPA_CPUFEATURES_H
@@ -0,0 +1,99 @@
+#ifndef CRPROPA_DATATABLE_H
+#define CRPROPA_DATATABLE_H
+
+#include "crpropa/Referenced.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace crpropa {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ @class DataTable
+ @brief Numerical table read from a CRPropa data file.
+
+ The table consists of rows of (possibly different numbers of) double values.
+ Text files are parsed line by line, skipping lines starting with '#'.
+
+ Tables can be precompiled into a binary file (see saveBinary). If a binary
+ file with the name given by binaryFilename() exists next to the text file,
+ it is memory-mapped instead of parsing the text file, which makes loading
+ the large interaction tables fast. Binary files with an inconsistent header
+ or row offsets are ignored with a warning.
+ Binary layout (native byte order):
+ . header:  char magic[8] = "CRPTAB", uint32 version, uint32 reserved, uint64 number of rows, uint64 number of values
+ . uint64 row offsets (number of rows + 1)
+ . double values
+
+ Memory-mapped tables are cached process-wide by file name, so that module
+ instances using the same data file map it only once. Tables parsed from text
+ are not cached. The interaction modules copy the values they need into their
+ own vectors in either case, so the table memory is not shared between them.
+ */
+class DataTable: public Referenced {
+public:
+	static const uint32_t binaryVersion = 1;
+
+	~DataTable();
+
+	/** Load a table, either from the cache, the binary file or the text file.
+	 @param filename	name of the text data file
+	 */
+	static ref_ptr<DataTable> load(const std::string &filename);
+	/// Remove all memory-mapped tables from the process-wide cache
+	static void clearCache();
+	/// Name of the binary file belonging to a text data file: .txt is replaced by .bin
+	static std::string binaryFilename(const std::string &filename);
+
+	/// Write the table to a binary file
+	void saveBinary(const std::string &filename) const;
+
+	/// Number of rows
+	size_t rows() const;
+	/// Number of values in the given row
+	size_t rowSize(size_t row) const;
+	/// Values in the given row
+	const double *row(size_t row) const;
+	/// Values in the given row, throws with the file name and line if the
+	/// row has less than minSize values
+	const double *row(size_t row, size_t minSize) const;
+	/// Total number of values in all rows
+	size_t size() const;
+	/// All values, row by row
+	const double *data() const;
+	/// Value in the given row and column
+	double get(size_t row, size_t column) const;
+	/// True if the table is memory-mapped from a binary file
+	bool isMapped() const;
+
+private:
+	DataTable();
+	DataTable(const DataTable &);
+	DataTable &operator=(const DataTable &);
+
+	void readText(const std::string &filename);
+	bool mapBinary(const std::string &filename);
+
+	std::string filename;
+	std::vector<double> ownValues;
+	std::vector<uint64_t> ownOffsets;
+	std::vector<size_t> ownLines;	// line of each row in the text file
+
+	const double *values;
+	const uint64_t *offsets;
+	size_t nRows;
+
+	void *mapping;
+	size_t mappingSize;
+};
+
+/** @}*/
+
+} // namespace crpropa
+
+#endif // CRPROPA_DATATABLE_H
@@ -7,14 +7,23 @@
 #include "kiss/string.h"
 #include "kiss/logger.h"
 
+#include <algorithm>
 #include <vector>
 #include <type_traits>
 #include <string>
 #include <sstream>  
-#if HAVE_SIMD
+#include <cstring>
+#include <stdint.h>
+// The vectorized tricubic interpolation needs SSE only, which is part of the
+// x86-64 baseline, so it does not depend on SIMD_EXTENSIONS anymore.
+// HAVE_SIMD is still accepted to enable it on other targets with SSE.
+#if defined(HAVE_SIMD) || defined(__SSE__) || defined(_M_X64)
+#define CRPROPA_HAVE_SSE
+#endif
+#ifdef CRPROPA_HAVE_SSE
 #include <immintrin.h>
 #include <smmintrin.h>
-#endif // HAVE_SIMD
+#endif // CRPROPA_HAVE_SSE
 
 namespace crpropa {
 
@@ -27,6 +36,98 @@ enum interpolationType {
   NEAREST_NEIGHBOUR
 };
 
+/** Order of the grid points in memory.
+ROW_MAJOR: z-index changing the fastest (standard)
+BRICKED: bricks of 4x4x4 grid points stored contiguously, so that the neighbours
+used in an interpolation are close in memory */
+enum gridLayoutType {
+  ROW_MAJOR = 0,
+  BRICKED
+};
+
+/** Storage of the grid values.
+FLOAT32: single (or double) precision values as given by the grid type (standard)
+FLOAT16: IEEE half precision, scaled to the largest absolute value of the grid
+BFLOAT16: bfloat16, same range as single precision with 8 bit mantissa */
+enum gridStorageType {
+  FLOAT32 = 0,
+  FLOAT16,
+  BFLOAT16
+};
+
+/** Convert to IEEE half precision, rounding to nearest even */
+inline uint16_t floatToHalf(float f) {
+	uint32_t x;
+	std::memcpy(&x, &f, sizeof(x));
+	uint32_t sign = (x >> 16) & 0x8000;
+	uint32_t mant = x & 0x007fffff;
+	if (((x >> 23) & 0xff) == 0xff) // inf and nan
+		return sign | 0x7c00 | (mant ? 0x200 : 0);
+	int exp = int((x >> 23) & 0xff) - 127 + 15;
+	if (exp >= 31) // overflow
+		return sign | 0x7c00;
+	if (exp <= 0) { // subnormal half or zero
+		if (exp < -10)
+			return sign;
+		mant |= 0x00800000;
+		int shift = 14 - exp;
+		uint32_t h = mant >> shift;
+		uint32_t rest = mant & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if ((rest > halfway) || ((rest == halfway) && (h & 1)))
+			h++;
+		return sign | h;
+	}
+	uint32_t h = (uint32_t(exp) << 10) | (mant >> 13);
+	uint32_t rest = mant & 0x1fff;
+	if ((rest > 0x1000) || ((rest == 0x1000) && (h & 1)))
+		h++; // a carry into the exponent is correct
+	return sign | h;
+}
+
+/** Convert from IEEE half precision */
+inline float halfToFloat(uint16_t h) {
+	uint32_t sign = uint32_t(h & 0x8000) << 16;
+	uint32_t exp = (h >> 10) & 0x1f;
+	uint32_t mant = h & 0x3ff;
+	uint32_t x;
+	if (exp == 0x1f) {
+		x = sign | 0x7f800000 | (mant << 13);
+	} else if (exp != 0) {
+		x = sign | ((exp + 112) << 23) | (mant << 13);
+	} else if (mant == 0) {
+		x = sign;
+	} else { // subnormal half, normalized as float
+		uint32_t e = 0;
+		while (!(mant & 0x400)) {
+			mant <<= 1;
+			e++;
+		}
+		x = sign | ((113 - e) << 23) | ((mant & 0x3ff) << 13);
+	}
+	float f;
+	std::memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+/** Convert to bfloat16, rounding to nearest even */
+inline uint16_t floatToBFloat16(float f) {
+	uint32_t x;
+	std::memcpy(&x, &f, sizeof(x));
+	if ((x & 0x7fffffff) > 0x7f800000) // nan
+		return (x >> 16) | 0x40;
+	x += 0x7fff + ((x >> 16) & 1);
+	return x >> 16;
+}
+
+/** Convert from bfloat16 */
+inline float bfloat16ToFloat(uint16_t h) {
+	uint32_t x = uint32_t(h) << 16;
+	float f;
+	std::memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
 /** Lower and upper neighbour in a periodically continued unit grid */
 inline void periodicClamp(double x, int n, int &lo, int &hi) {
 	lo = ((int(floor(x)) % (n)) + (n)) % (n);
@@ -80,6 +181,7 @@ public:
 	bool reflective;	// using reflective repetition of the grid instead of periodic
 	interpolationType ipol;	// Interpolation type used between grid points
 	bool clipVolume;	// Set grid values to 0 outside the volume if true
+	gridLayoutType layout;	// Order of the grid points in memory
 
 	/** Constructor for cubic grid
 	 @param	origin	Position of the lower left front corner of the volume
@@ -87,7 +189,7 @@ public:
 	 @param spacing	Spacing between grid points
 	 */
 	GridProperties(Vector3d origin, size_t N, double spacing) :
-		origin(origin), Nx(N), Ny(N), Nz(N), spacing(Vector3d(spacing)), reflective(false), ipol(TRILINEAR), clipVolume(false) {
+		origin(origin), Nx(N), Ny(N), Nz(N), spacing(Vector3d(spacing)), reflective(false), ipol(TRILINEAR), clipVolume(false), layout(ROW_MAJOR) {
 	}
 
 	/** Constructor for non-cubic grid
@@ -98,7 +200,7 @@ public:
 	 @param spacing	Spacing between grid points
 	 */
 	GridProperties(Vector3d origin, size_t Nx, size_t Ny, size_t Nz, double spacing) :
-		origin(origin), Nx(Nx), Ny(Ny), Nz(Nz), spacing(Vector3d(spacing)), reflective(false), ipol(TRILINEAR), clipVolume(false) {
+		origin(origin), Nx(Nx), Ny(Ny), Nz(Nz), spacing(Vector3d(spacing)), reflective(false), ipol(TRILINEAR), clipVolume(false), layout(ROW_MAJOR) {
 	}
 
 	/** Constructor for non-cubic grid with spacing vector
@@ -109,7 +211,7 @@ public:
 	 @param spacing	Spacing vector between grid points
 	*/
 	GridProperties(Vector3d origin, size_t Nx, size_t Ny, size_t Nz, Vector3d spacing) :
-		origin(origin), Nx(Nx), Ny(Ny), Nz(Nz), spacing(spacing), reflective(false), ipol(TRILINEAR), clipVolume(false) {
+		origin(origin), Nx(Nx), Ny(Ny), Nz(Nz), spacing(spacing), reflective(false), ipol(TRILINEAR), clipVolume(false), layout(ROW_MAJOR) {
 	}
 	
 	virtual ~GridProperties() {
@@ -131,6 +233,12 @@ public:
 		clipVolume = b;
 	}
 
+	/** set the order of the grid points in memory.
+	 * @param l: gridLayoutType (ROW_MAJOR, BRICKED) */
+	void setLayout(gridLayoutType l) {
+		layout = l;
+	}
+
 	/** show all GridProperty parameters
 	 * @param unit unit for the lengthscale (origin, spacing). Default is 1 = SI units
 	 */
@@ -146,6 +254,31 @@ public:
 	}
 };
 
+/**
+ @class GridMapping
+ @brief Memory mapping of a binary grid file (see mapGrid3f and mapGrid1f)
+
+ The file is mapped read-only: processes mapping the same file share the
+ page-cached values, which do not count against the memory commit limit.
+ */
+class GridMapping: public Referenced {
+public:
+	GridMapping(const std::string &filename);
+	~GridMapping();
+	const std::string &getFilename() const;
+	const char *data() const;
+	size_t size() const;
+
+private:
+	GridMapping(const GridMapping &);
+	GridMapping &operator=(const GridMapping &);
+
+	std::string filename;
+	char *address;
+	size_t length;
+	bool mapped; /**< false if the file was read into memory instead */
+};
+
 /**
  @class Grid
  @brief Template class for fields on a periodic grid with trilinear interpolation
@@ -158,6 +291,11 @@ public:
 template<typename T>
 class Grid: public Referenced {
 	std::vector<T> grid;
+	T *values; /**< Grid values, either in grid or in the mapping. 0 for reduced precision storage */
+	ref_ptr<GridMapping> mapping; /**< Memory-mapped file holding the values, if any */
+	gridStorageType storageType; /**< Storage of the values */
+	std::vector<uint16_t> packed; /**< Values in reduced precision, one entry per float component */
+	float packScale; /**< Factor applied to the decoded values in reduced precision */
 	size_t Nx, Ny, Nz; /**< Number of grid points */
 	Vector3d origin; /**< Origin of the volume that is represented by the grid. */
 	Vector3d gridOrigin; /**< Grid origin */
@@ -165,6 +303,7 @@ class Grid: public Referenced {
 	bool clipVolume; /**< If set to true, all values outside of the grid will be 0*/
 	bool reflective; /**< If set to true, the grid is repeated reflectively instead of periodically */
 	interpolationType ipolType; /**< Type of interpolation between the grid points */
+	gridLayoutType layout; /**< Order of the grid points in memory */
 
 public:
 	/** Constructor for cubic grid
@@ -172,7 +311,7 @@ public:
 	 @param	N		Number of grid points in one direction
 	 @param spacing	Spacing between grid points
 	 */
-	Grid(Vector3d origin, size_t N, double spacing) {
+	Grid(Vector3d origin, size_t N, double spacing) : layout(ROW_MAJOR) {
 		setOrigin(origin);
 		setGridSize(N, N, N);
 		setSpacing(Vector3d(spacing));
@@ -188,7 +327,7 @@ public:
 	 @param	Nz		Number of grid points in z-direction
 	 @param spacing	Spacing between grid points
 	 */
-	Grid(Vector3d origin, size_t Nx, size_t Ny, size_t Nz, double spacing) {
+	Grid(Vector3d origin, size_t Nx, size_t Ny, size_t Nz, double spacing) : layout(ROW_MAJOR) {
 		setOrigin(origin);
 		setGridSize(Nx, Ny, Nz);
 		setSpacing(Vector3d(spacing));
@@ -204,7 +343,7 @@ public:
 	 @param	Nz		Number of grid points in z-direction
 	 @param spacing	Spacing vector between grid points
 	*/
-	Grid(Vector3d origin, size_t Nx, size_t Ny, size_t Nz, Vector3d spacing) {
+	Grid(Vector3d origin, size_t Nx, size_t Ny, size_t Nz, Vector3d spacing) : layout(ROW_MAJOR) {
 		setOrigin(origin);
 		setGridSize(Nx, Ny, Nz);
 		setSpacing(spacing);
@@ -217,22 +356,74 @@ public:
 	 @param p	GridProperties instance
      */
 	Grid(const GridProperties &p) :
-		origin(p.origin), spacing(p.spacing), reflective(p.reflective), ipolType(p.ipol) {
+		origin(p.origin), spacing(p.spacing), reflective(p.reflective), ipolType(p.ipol), layout(p.layout) {
 		setGridSize(p.Nx, p.Ny, p.Nz);
 		setClipVolume(p.clipVolume);
 	}
 
+	/** Constructor for a grid with the values in a memory-mapped file, in ROW_MAJOR layout
+	 @param p		GridProperties instance
+	 @param mapping	mapped file
+	 @param offset	position of the first value in the file, in bytes
+	 */
+	Grid(const GridProperties &p, ref_ptr<GridMapping> mapping, size_t offset) :
+		mapping(mapping), Nx(p.Nx), Ny(p.Ny), Nz(p.Nz), origin(p.origin), spacing(p.spacing), reflective(p.reflective), ipolType(p.ipol), layout(ROW_MAJOR) {
+		if (offset + sizeof(T) * Nx * Ny * Nz > mapping->size())
+			throw std::runtime_error("Grid: mapped file " + mapping->getFilename() + " too short");
+		// the mapping is read-only, see get()
+		values = reinterpret_cast<T *>(const_cast<char *>(mapping->data()) + offset);
+		storageType = FLOAT32;
+		packScale = 1;
+		setOrigin(origin);
+		setClipVolume(p.clipVolume);
+	}
+
+	/** Copies of a memory-mapped grid share the read-only mapping */
+	Grid(const Grid<T> &g) :
+		Referenced(), grid(g.grid), mapping(g.mapping), storageType(g.storageType), packed(g.packed), packScale(g.packScale),
+		Nx(g.Nx), Ny(g.Ny), Nz(g.Nz), origin(g.origin), gridOrigin(g.gridOrigin),
+		spacing(g.spacing), clipVolume(g.clipVolume), reflective(g.reflective), ipolType(g.ipolType), layout(g.layout) {
+		values = mapping.valid() ? g.values : (grid.empty() ? 0 : &grid[0]);
+	}
+
+	Grid<T> &operator=(const Grid<T> &g) {
+		grid = g.grid;
+		mapping = g.mapping;
+		values = mapping.valid() ? g.values : (grid.empty() ? 0 : &grid[0]);
+		storageType = g.storageType;
+		packed = g.packed;
+		packScale = g.packScale;
+		Nx = g.Nx;
+		Ny = g.Ny;
+		Nz = g.Nz;
+		origin = g.origin;
+		gridOrigin = g.gridOrigin;
+		spacing = g.spacing;
+		clipVolume = g.clipVolume;
+		reflective = g.reflective;
+		ipolType = g.ipolType;
+		layout = g.layout;
+		return *this;
+	}
+
 	void setOrigin(Vector3d origin) {
 		this->origin = origin;
 		this->gridOrigin = origin + spacing/2;
 	}
 
-	/** Resize grid, also enlarges the volume as the spacing stays constant */
+	/** Resize grid, also enlarges the volume as the spacing stays constant.
+	 A memory-mapped grid is released and the grid is zero-initialized,
+	 with the values stored as FLOAT32. */
 	void setGridSize(size_t Nx, size_t Ny, size_t Nz) {
 		this->Nx = Nx;
 		this->Ny = Ny;
 		this->Nz = Nz;
-		grid.resize(Nx * Ny * Nz);
+		mapping = 0;
+		storageType = FLOAT32;
+		std::vector<uint16_t>().swap(packed);
+		packScale = 1;
+		grid.resize(storageSize());
+		values = grid.empty() ? 0 : &grid[0];
 		setOrigin(origin);
 	}
 
@@ -267,6 +458,90 @@ public:
 		return ipolType;
 	}
 
+	/** Convert the values to the given storage type. Reduced precision storage
+	 halves the memory of single precision grids, the values are decoded when
+	 they are read, e.g. in interpolate, getValue and the get functions returning values.
+	 get() is not available for reduced precision storage, setValue() encodes the value.
+	 Only single precision grids (Grid1f, Grid3f) can be stored in reduced precision.
+	 */
+	void setStorageType(gridStorageType type) {
+		if (type == storageType)
+			return;
+		if ((type != FLOAT32) && !(std::is_same<T, float>::value || std::is_same<T, Vector3f>::value))
+			throw std::runtime_error("Grid: reduced precision storage is only available for single precision grids");
+		if ((type != FLOAT32) && (type != FLOAT16) && (type != BFLOAT16))
+			throw std::runtime_error("Grid: unknown storage type");
+
+		const size_t n = storageSize();
+		const size_t nc = sizeof(T) / sizeof(float);
+		if (type == FLOAT32) {
+			std::vector<T> decoded(n);
+			for (size_t i = 0; i < n; i++)
+				decoded[i] = load(i);
+			grid.swap(decoded);
+			values = grid.empty() ? 0 : &grid[0];
+			std::vector<uint16_t>().swap(packed);
+			packScale = 1;
+			storageType = type;
+			return;
+		}
+
+		std::vector<float> f(n * nc);
+		float maxValue = 0;
+		for (size_t i = 0; i < n; i++) {
+			toFloats(load(i), &f[i * nc]);
+			for (size_t c = 0; c < nc; c++)
+				maxValue = std::max(maxValue, std::fabs(f[i * nc + c]));
+		}
+		// half precision covers 6e-8 to 65504: map the largest value to 2^15,
+		// a scale of 0 marks a grid of zeros (see setValue)
+		float scale = 1;
+		if (type == FLOAT16)
+			scale = maxValue / 32768.f;
+		std::vector<uint16_t> p(n * nc);
+		for (size_t i = 0; i < n * nc; i++)
+			p[i] = encode(type, f[i], scale);
+
+		packed.swap(p);
+		packScale = scale;
+		std::vector<T>().swap(grid);
+		mapping = 0;
+		values = 0;
+		storageType = type;
+	}
+
+	gridStorageType getStorageType() const {
+		return storageType;
+	}
+
+	/** Change the order of the grid points in memory. The values are kept. */
+	void setLayout(gridLayoutType l) {
+		if (l == layout)
+			return;
+		if ((l != ROW_MAJOR) && (l != BRICKED))
+			throw std::runtime_error("Grid: unknown layout");
+
+		gridStorageType type = storageType;
+		setStorageType(FLOAT32);
+		std::vector<T> v(Nx * Ny * Nz);
+		for (size_t ix = 0; ix < Nx; ix++)
+			for (size_t iy = 0; iy < Ny; iy++)
+				for (size_t iz = 0; iz < Nz; iz++)
+					v[(ix * Ny + iy) * Nz + iz] = getValue(ix, iy, iz);
+
+		layout = l;
+		setGridSize(Nx, Ny, Nz);
+		for (size_t ix = 0; ix < Nx; ix++)
+			for (size_t iy = 0; iy < Ny; iy++)
+				for (size_t iz = 0; iz < Nz; iz++)
+					values[index(ix, iy, iz)] = v[(ix * Ny + iy) * Nz + iz];
+		setStorageType(type);
+	}
+
+	gridLayoutType getLayout() const {
+		return layout;
+	}
+
 	std::string getInterpolationTypeName() {
 		if (ipolType == TRILINEAR)
 			return "TRILINEAR";
@@ -301,7 +576,14 @@ public:
 
 	/** Calculates the total size of the grid in bytes */
 	size_t getSizeOf() const {
-		return sizeof(grid) + (sizeof(grid[0]) * grid.size());
+		if (storageType != FLOAT32)
+			return sizeof(grid) + sizeof(packed[0]) * packed.size();
+		return sizeof(grid) + (sizeof(T) * storageSize());
+	}
+
+	/** True if the values are memory-mapped from a file */
+	bool isMapped() const {
+		return mapping.valid();
 	}
 
 	Vector3d getSpacing() const {
@@ -334,44 +616,79 @@ public:
 			return trilinearInterpolate(position);
 	}
 
-	/** Inspector & Mutator */
+	/** Inspector & Mutator, not available for reduced precision storage and memory-mapped grids */
 	T &get(size_t ix, size_t iy, size_t iz) {
-		return grid[ix * Ny * Nz + iy * Nz + iz];
+		if (values == 0)
+			throw std::runtime_error("Grid: no references to values in reduced precision, use getValue");
+		if (mapping.valid())
+			throw std::runtime_error("Grid: values of a memory-mapped grid are read-only, use getValue");
+		return values[index(ix, iy, iz)];
 	}
 
 	/** Inspector */
 	const T &get(size_t ix, size_t iy, size_t iz) const {
-		return grid[ix * Ny * Nz + iy * Nz + iz];
+		if (values == 0)
+			throw std::runtime_error("Grid: no references to values in reduced precision, use getValue");
+		return values[index(ix, iy, iz)];
 	}
 
-	const T &periodicGet(size_t ix, size_t iy, size_t iz) const {
+	T periodicGet(size_t ix, size_t iy, size_t iz) const {
 		ix = periodicBoundary(ix, Nx);
 		iy = periodicBoundary(iy, Ny);
 		iz = periodicBoundary(iz, Nz);
-		return grid[ix * Ny * Nz + iy * Nz + iz];
+		return load(index(ix, iy, iz));
 	}
 
-	const T &reflectiveGet(size_t ix, size_t iy, size_t iz) const {
+	T reflectiveGet(size_t ix, size_t iy, size_t iz) const {
 		ix = reflectiveBoundary(ix, Nx);
 		iy = reflectiveBoundary(iy, Ny);
 		iz = reflectiveBoundary(iz, Nz);
-		return grid[ix * Ny * Nz + iy * Nz + iz];
+		return load(index(ix, iy, iz));
 	}
 
-	T getValue(size_t ix, size_t iy, size_t iz) {
-		return grid[ix * Ny * Nz + iy * Nz + iz];
+	T getValue(size_t ix, size_t iy, size_t iz) const {
+		return load(index(ix, iy, iz));
 	}
 
+	/** Mutator, encodes the value for reduced precision storage. Not available for memory-mapped grids.
+	 In half precision all values are rescaled if the value is out of the range of the current values,
+	 so that writing a grid value by value in half precision is slow. */
 	void setValue(size_t ix, size_t iy, size_t iz, T value) {
-		grid[ix * Ny * Nz + iy * Nz + iz] = value;
+		if (storageType == FLOAT32) {
+			get(ix, iy, iz) = value;
+			return;
+		}
+		const size_t nc = sizeof(T) / sizeof(float);
+		float f[nc];
+		toFloats(value, f);
+		if (storageType == FLOAT16) {
+			float maxValue = 0;
+			for (size_t c = 0; c < nc; c++)
+				maxValue = std::max(maxValue, std::fabs(f[c]));
+			if ((maxValue > 0) && !(maxValue <= 65504.f * packScale)) {
+				setStorageType(FLOAT32);
+				get(ix, iy, iz) = value;
+				setStorageType(FLOAT16);
+				return;
+			}
+		}
+		uint16_t *p = &packed[index(ix, iy, iz) * nc];
+		for (size_t c = 0; c < nc; c++)
+			p[c] = encode(storageType, f[c], packScale);
 	}
 
-	/** Return a reference to the grid values */
+	/** Return a reference to the grid values in ROW_MAJOR layout, not available for memory-mapped grids */
 	std::vector<T> &getGrid() {
+		if (mapping.valid())
+			throw std::runtime_error("Grid: values of a memory-mapped grid are not stored in a vector");
+		if (layout != ROW_MAJOR)
+			throw std::runtime_error("Grid: getGrid is only available for the ROW_MAJOR layout");
+		if (storageType != FLOAT32)
+			throw std::runtime_error("Grid: getGrid is not available for reduced precision storage");
 		return grid;
 	}
 
-	/** Position of the grid point of a given index */
+	/** Position of the grid point of a given index in ROW_MAJOR order */
 	Vector3d positionFromIndex(int index) const {
 		int ix = index / (Ny * Nz);
 		int iy = (index / Nz) % Ny;
@@ -401,23 +718,87 @@ public:
 			iy = (iy + Ny * (iy < 0)) % Ny;
 			iz = (iz + Nz * (iz < 0)) % Nz;
 		}
-		return get(ix, iy, iz);
+		return getValue(ix, iy, iz);
 	}
 
 private:
-	#ifdef HAVE_SIMD
+	/** Position of a grid point in the values */
+	size_t index(size_t ix, size_t iy, size_t iz) const {
+		if (layout == ROW_MAJOR)
+			return ix * Ny * Nz + iy * Nz + iz;
+		// brick index, then position within the 4x4x4 brick
+		size_t brick = ((ix >> 2) * ((Ny + 3) >> 2) + (iy >> 2)) * ((Nz + 3) >> 2) + (iz >> 2);
+		return (brick << 6) + ((ix & 3) << 4) + ((iy & 3) << 2) + (iz & 3);
+	}
+
+	/** Number of stored grid points, including the padding of incomplete bricks */
+	size_t storageSize() const {
+		if (layout == ROW_MAJOR)
+			return Nx * Ny * Nz;
+		return ((Nx + 3) >> 2) * ((Ny + 3) >> 2) * ((Nz + 3) >> 2) * 64;
+	}
+
+	/** Value at a position in the values, decoded for reduced precision storage */
+	T load(size_t i) const {
+		if (storageType == FLOAT32)
+			return values[i];
+		const size_t nc = sizeof(T) / sizeof(float);
+		float f[nc];
+		const uint16_t *p = &packed[i * nc];
+		if (storageType == FLOAT16) {
+			for (size_t c = 0; c < nc; c++)
+				f[c] = halfToFloat(p[c]) * packScale;
+		} else {
+			for (size_t c = 0; c < nc; c++)
+				f[c] = bfloat16ToFloat(p[c]);
+		}
+		T v = T();
+		fromFloats(f, v);
+		return v;
+	}
+
+	static uint16_t encode(gridStorageType type, float f, float scale) {
+		if (type == FLOAT16)
+			return floatToHalf((scale > 0) ? f / scale : 0.f);
+		return floatToBFloat16(f);
+	}
+
+	// components of the values for reduced precision storage, which is
+	// restricted to float and Vector3f (see setStorageType)
+	static void toFloats(float v, float *f) {
+		f[0] = v;
+	}
+	static void toFloats(const Vector3f &v, float *f) {
+		f[0] = v.x;
+		f[1] = v.y;
+		f[2] = v.z;
+	}
+	template<typename U>
+	static void toFloats(const U &, float *) {
+	}
+	static void fromFloats(const float *f, float &v) {
+		v = f[0];
+	}
+	static void fromFloats(const float *f, Vector3f &v) {
+		v = Vector3f(f[0], f[1], f[2]);
+	}
+	template<typename U>
+	static void fromFloats(const float *, U &) {
+	}
+
+	#ifdef CRPROPA_HAVE_SSE
 	__m128 simdperiodicGet(size_t ix, size_t iy, size_t iz) const {
 		ix = periodicBoundary(ix, Nx);
 		iy = periodicBoundary(iy, Ny);
 		iz = periodicBoundary(iz, Nz);
-		return convertVector3fToSimd(grid[ix * Ny * Nz + iy * Nz + iz]);
+		return convertVector3fToSimd(load(index(ix, iy, iz)));
 	}
 
 	__m128 simdreflectiveGet(size_t ix, size_t iy, size_t iz) const {
 		ix = reflectiveBoundary(ix, Nx);
 		iy = reflectiveBoundary(iy, Ny);
 		iz = reflectiveBoundary(iz, Nz);
-		return convertVector3fToSimd(grid[ix * Ny * Nz + iy * Nz + iz]);
+		return convertVector3fToSimd(load(index(ix, iy, iz)));
 	}
 
 	__m128 convertVector3fToSimd(const Vector3f v) const {
@@ -454,10 +835,10 @@ private:
 		__m128 res = _mm_add_ps(_mm_add_ps(_mm_add_ps(term3,term2),term),p1);
 		return res;
 	}
-	#endif // HAVE_SIMD
+	#endif // CRPROPA_HAVE_SSE
 	/** Interpolate the grid tricubic at a given position (see https://www.paulinternet.nl/?page=bicubic, http://graphics.cs.cmu.edu/nsp/course/15-462/Fall04/assts/catmullRom.pdf) */
 	Vector3f tricubicInterpolate(Vector3f, const Vector3d &position) const {
-		#ifdef HAVE_SIMD
+		#ifdef CRPROPA_HAVE_SSE
 		// position on a unit grid
 		Vector3d r = (position - gridOrigin) / spacing;
 
@@ -490,9 +871,9 @@ private:
 		}
 		__m128 result = CubicInterpolate(interpolateVaryX[0], interpolateVaryX[1], interpolateVaryX[2], interpolateVaryX[3], fX);
 		return convertSimdToVector3f(result);
-		#else // HAVE_SIMD
-		throw std::runtime_error( "Tried to use tricubic Interpolation without SIMD_EXTENSION. SIMD Optimization is necessary for tricubic interpolation of vector grids.\n");
-		#endif // HAVE_SIMD	
+		#else // CRPROPA_HAVE_SSE
+		throw std::runtime_error( "Tried to use tricubic Interpolation on a platform without SSE. SIMD Optimization is necessary for tricubic interpolation of vector grids.\n");
+		#endif // CRPROPA_HAVE_SSE	
 	}
 
 	/** Vectorized cubic Interpolator in 1D that returns a scalar (see https://www.paulinternet.nl/?page=bicubic, http://graphics.cs.cmu.edu/nsp/course/15-462/Fall04/assts/catmullRom.pdf) */
@@ -569,14 +950,14 @@ private:
 
 		/** trilinear interpolation (see http://paulbourke.net/miscellaneous/interpolation) */
 		T b(0.);
-		b += get(iX0, iY0, iZ0) * fX1 * fY1 * fZ1;
-		b += get(iX1, iY0, iZ0) * fX0 * fY1 * fZ1;
-		b += get(iX0, iY1, iZ0) * fX1 * fY0 * fZ1;
-		b += get(iX0, iY0, iZ1) * fX1 * fY1 * fZ0;
-		b += get(iX1, iY0, iZ1) * fX0 * fY1 * fZ0;
-		b += get(iX0, iY1, iZ1) * fX1 * fY0 * fZ0;
-		b += get(iX1, iY1, iZ0) * fX0 * fY0 * fZ1;
-		b += get(iX1, iY1, iZ1) * fX0 * fY0 * fZ0;
+		b += load(index(iX0, iY0, iZ0)) * fX1 * fY1 * fZ1;
+		b += load(index(iX1, iY0, iZ0)) * fX0 * fY1 * fZ1;
+		b += load(index(iX0, iY1, iZ0)) * fX1 * fY0 * fZ1;
+		b += load(index(iX0, iY0, iZ1)) * fX1 * fY1 * fZ0;
+		b += load(index(iX1, iY0, iZ1)) * fX0 * fY1 * fZ0;
+		b += load(index(iX0, iY1, iZ1)) * fX1 * fY0 * fZ0;
+		b += load(index(iX1, iY1, iZ0)) * fX0 * fY0 * fZ1;
+		b += load(index(iX1, iY1, iZ1)) * fX0 * fY0 * fZ0;
 
 		return b;
 	}
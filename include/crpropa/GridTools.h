@@ -74,16 +74,21 @@ void scaleGrid(ref_ptr<Grid1f> grid, double a);
 void scaleGrid(ref_ptr<Grid3f> grid, double a);
 
 /** Fill vector grid from provided magnetic field.
+ The field is evaluated at the cell centers, one row along z per call of
+ MagneticField::getFields, with the rows distributed over the OpenMP threads.
  @param grid		a vector grid (Grid3f)
  @param field		the magnetic field 
+ @param showProgress	show a progress bar (one step per row)
  */
-void fromMagneticField(ref_ptr<Grid3f> grid, ref_ptr<MagneticField> field);
+void fromMagneticField(ref_ptr<Grid3f> grid, ref_ptr<MagneticField> field, bool showProgress = false);
 
-/** Fill scalar grid from provided magnetic field.
+/** Fill scalar grid with the strength of the provided magnetic field.
+ Evaluated in parallel like fromMagneticField.
  @param grid		a scalar grid (Grid1f)
  @param field		the magnetic field
+ @param showProgress	show a progress bar (one step per row)
  */
-void fromMagneticFieldStrength(ref_ptr<Grid1f> grid, ref_ptr<MagneticField> field);
+void fromMagneticFieldStrength(ref_ptr<Grid1f> grid, ref_ptr<MagneticField> field, bool showProgress = false);
 
 /** Load a Grid3f from a binary file with single precision.
  @param grid		a vector grid (Grid3f)
@@ -163,6 +168,40 @@ void dumpGridToTxt(ref_ptr<Grid3f> grid, std::string filename,
 void dumpGridToTxt(ref_ptr<Grid1f> grid, std::string filename,
 		double conversion = 1, bool storeProperties = false);
 
+/** Dump a Grid3f to a binary file including the grid properties, which can be
+ memory-mapped by mapGrid3f.
+ Binary layout (native byte order):
+ . header (128 bytes): char magic[8] = "CRPGRID", uint32 version, uint32 number of components,
+   uint64 Nx, Ny, Nz, double origin[3], double spacing[3], uint32 reflective, uint32 clipVolume,
+   uint32 interpolation type, 28 bytes reserved
+ . float values with the z-index changing the fastest, vector components in xyz-order
+ @param grid		a vector grid (Grid3f)
+ @param filename	name of output file
+ @param conversion	multiply every point in grid by a conversion factor
+ */
+void dumpGridBinary(ref_ptr<Grid3f> grid, std::string filename,
+		double conversion = 1);
+
+/** Dump a Grid1f to a binary file including the grid properties, see dumpGridBinary for Grid3f.
+ @param grid		a scalar grid (Grid1f)
+ @param filename	name of output file
+ @param conversion	multiply every point in grid by a conversion factor
+ */
+void dumpGridBinary(ref_ptr<Grid1f> grid, std::string filename,
+		double conversion = 1);
+
+/** Memory-map a Grid3f from a binary file written by dumpGridBinary.
+ The values are not copied: the operating system loads them on demand and
+ processes on one node share the same page-cached copy.
+ @param filename	name of input file
+ */
+ref_ptr<Grid3f> mapGrid3f(std::string filename);
+
+/** Memory-map a Grid1f from a binary file written by dumpGridBinary.
+ @param filename	name of input file
+ */
+ref_ptr<Grid1f> mapGrid1f(std::string filename);
+
 #ifdef CRPROPA_HAVE_FFTW3F
 /**
  Calculate the omnidirectional power spectrum E(k) for a given turbulent field
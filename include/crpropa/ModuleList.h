@@ -29,6 +29,25 @@ public:
 	ModuleList();
 	virtual ~ModuleList();
 	void setShowProgress(bool show = true); ///< activate a progress bar
+	/** Propagate the secondaries of a candidate as OpenMP tasks, which idle threads can take over.
+	 Only used in parallel runs (candidate vector or source) and if the secondaries are propagated
+	 after their parent (secondariesFirst = false). Requires OpenMP 4.0.
+	 */
+	void setSecondaryTasks(bool tasks = true);
+	bool getSecondaryTasks() const;
+	/** Release secondaries as soon as they and their own secondaries are propagated, instead of keeping
+	 them in Candidate::secondaries until the run of the primary is finished. The memory then scales
+	 with the depth of the cascade instead of its size. Used if the secondaries are propagated after
+	 their parent and not as tasks. Modules that keep references (e.g. ParticleCollector) still do so.
+	 */
+	void setReleaseSecondaries(bool release = true);
+	bool getReleaseSecondaries() const;
+	/** First counter-based random stream of the primaries in the next run with a source.
+	 Each run with a source advances it by the number of candidates, so that consecutive runs
+	 draw different primaries. Only used if Random::enableStreams was called.
+	 */
+	void setPrimaryStreamOffset(uint64_t offset);
+	uint64_t getPrimaryStreamOffset() const;
 
 	void add(Module* module);
 	void remove(std::size_t i);
@@ -58,8 +77,21 @@ public:
 	void dumpCandidate(Candidate* cand) const;
 
 private:
+	/// run simulation for a single candidate, drawing random numbers from the given counter-based stream if enabled
+	void runStream(Candidate* candidate, bool recursive, bool secondariesFirst, uint64_t stream);
+	/// run simulation for a primary candidate, waiting for its secondary tasks
+	void runPrimary(Candidate* candidate, bool recursive, bool secondariesFirst, uint64_t stream);
+	/// run simulation for a secondary candidate as task
+	void runTask(ref_ptr<Candidate> candidate, bool recursive, uint64_t stream);
+	bool useSecondaryTasks(bool recursive, bool secondariesFirst) const;
+	/// propagate all secondaries of a finished candidate, depth-first without recursion
+	void runSecondaries(Candidate* candidate, uint64_t stream);
+
 	module_list_t modules;
 	bool showProgress;
+	bool secondaryTasks;
+	bool releaseSecondaries;
+	uint64_t primaryStreamOffset;
 	Output* interruptAction;
 	bool haveInterruptAction = false;
 	std::vector<int> notFinished; // list with not finished numbers of candidates
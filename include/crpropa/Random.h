@@ -106,6 +106,12 @@ protected:
 	uint32_t *pNext;// next value to get from state
 	int left;// number of values left before reload needed
 
+	bool streamMode;// draw from the counter-based stream instead of the state
+	uint32_t streamKey[2];// Philox key (global stream seed)
+	uint32_t streamCounter[4];// Philox counter (block, step, stream)
+	uint32_t streamBuffer[4];// output of the last Philox block
+	int streamLeft;// number of values left in streamBuffer
+
 //Methods
 public:
 	/// initialize with a simple uint32_t
@@ -150,6 +156,8 @@ public:
 	/// Draw a random bin from a (unnormalized) cumulative distribution function, without leading zero.
 	size_t randBin(const std::vector<float> &cdf);
 	size_t randBin(const std::vector<double> &cdf);
+	/// Same as above for a cumulative distribution function of n values, e.g. a row of a larger table
+	size_t randBin(const double *cdf, size_t n);
 
 	/// Random point on a unit-sphere
 	Vector3d randVector();
@@ -201,6 +209,20 @@ public:
 	static void seedThreads(const uint32_t oneSeed);
 	static std::vector< std::vector<uint32_t> > getSeedThreads();
 
+	/// Enable counter-based random streams (Philox4x32-10) with the given seed.
+	/// ModuleList::run then selects a stream for every propagation step, keyed
+	/// by (seed, stream of the candidate, step), so that the results do not
+	/// depend on the number of threads or the OpenMP schedule.
+	static void enableStreams(uint64_t seed);
+	/// Disable counter-based streams and switch all instances back to the Mersenne Twister
+	static void disableStreams();
+	static bool haveStreams();
+	/// Draw the following numbers from the counter-based stream (seed, stream, step)
+	/// until the next call of setStream or seed.
+	void setStream(uint64_t stream, uint32_t step);
+	/// Stream of the secondary with the given index of a candidate with the given stream
+	static uint64_t deriveStream(uint64_t stream, uint64_t index);
+
 protected:
 	/// Initialize generator state with seed
 	/// See Knuth TAOCP Vol 2, 3rd Ed, p.106 for multiplier.
@@ -211,6 +233,8 @@ protected:
 	/// Generate N new values in state
 	/// Made clearer and faster by Matthew Bellew (matthew.bellew@home.com)
 	void reload();
+	/// Generate the next Philox4x32-10 block of the current stream
+	void reloadStream();
 	uint32_t hiBit( const uint32_t& u ) const {return u & 0x80000000UL;}
 	uint32_t loBit( const uint32_t& u ) const {return u & 0x00000001UL;}
 	uint32_t loBits( const uint32_t& u ) const {return u & 0x7fffffffUL;}
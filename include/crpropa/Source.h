@@ -527,6 +527,7 @@ public:
  */
 class SourceDensityGrid: public SourceFeature {
 	ref_ptr<Grid1f> grid;
+	std::vector<double> cdf;	// cumulative density in row-major cell order
 public:
 	/** Constructor
 	 @param densityGrid 	3D grid containing the density of sources in each cell
@@ -543,6 +544,7 @@ public:
  */
 class SourceDensityGrid1D: public SourceFeature {
 	ref_ptr<Grid1f> grid;	// 1D grid with Ny = Nz = 1
+	std::vector<double> cdf;	// cumulative density along x
 public:
 	/** Constructor
 	 @param densityGrid 	1D grid containing the density of sources in each cell, Ny and Nz must be 1
@@ -860,6 +862,10 @@ public:
 	If a weighting for different components is desired, the use of different densities in a densityList is recommended.
 
 	The sampling range of the position can be restricted. Default is a sampling for x in [-20, 20] * kpc, y in [-20, 20] * kpc and z in [-4, 4] * kpc.
+
+	By default the position is found by rejection sampling, which needs many density evaluations for peaked distributions.
+	Alternatively, the density can be tabulated once on a grid covering the sampling range (see setSamplingGrid).
+	Positions are then drawn from the grid cells as in SourceDensityGrid, without further density evaluations.
 */
 class SourceMassDistribution: public SourceFeature {
 private: 
@@ -869,6 +875,11 @@ private:
 	double yMin, yMax; 			//< y-range to sample positions
 	double zMin, zMax;			//< z-range to sample positions
 	int maxTries = 10000;		//< maximal number of tries to sample the position 
+	size_t nx = 0, ny = 0, nz = 0;	//< number of cells of the sampling grid, 0 for rejection sampling
+	int subsamples = 2;			//< density evaluations per cell and dimension
+	ref_ptr<SourceDensityGrid> samplingGrid;	//< tabulated density, if used
+
+	void updateSamplingGrid();
 
 public: 
 	/** Constructor
@@ -916,6 +927,13 @@ public:
 	*/
 	void setMaximalTries(int tries);
 
+	/** Tabulate the density on a grid covering the sampling range and sample the positions from this grid.
+		The grid is recomputed when the sampling range changes. Passing 0 cells returns to rejection sampling.
+		@param nx, ny, nz:	number of cells in x, y and z
+		@param subsamples:	the density in each cell is averaged over subsamples^3 points
+	*/
+	void setSamplingGrid(size_t nx, size_t ny, size_t nz, int subsamples = 2);
+
 	std::string getDescription();
 };
 
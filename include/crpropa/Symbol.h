@@ -0,0 +1,64 @@
+#ifndef CRPROPA_SYMBOL_H
+#define CRPROPA_SYMBOL_H
+
+#include <string>
+#include <cstddef>
+
+namespace crpropa {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ @class Symbol
+ @brief Interned string, used for candidate tags and property names.
+
+ All symbols with the same name refer to one entry of a process-wide table,
+ which is never cleared. Copying and comparing symbols does not touch the
+ string: symbols are equal if they refer to the same entry and are ordered by
+ the index of the entry in the table, i.e. in the order they were first created.
+ Creating a symbol from a string requires a lookup in the table; create symbols
+ used in hot paths once and keep them.
+ */
+class Symbol {
+public:
+	struct Entry {
+		std::string name;
+		size_t index;
+	};
+
+	/// The empty symbol
+	Symbol();
+	explicit Symbol(const std::string &name);
+	explicit Symbol(const char *name);
+
+	const std::string &str() const {
+		return entry->name;
+	}
+	size_t index() const {
+		return entry->index;
+	}
+
+	bool operator==(const Symbol &s) const {
+		return entry == s.entry;
+	}
+	bool operator!=(const Symbol &s) const {
+		return entry != s.entry;
+	}
+	bool operator<(const Symbol &s) const {
+		return entry->index < s.entry->index;
+	}
+
+	/// Number of interned symbols
+	static size_t count();
+
+private:
+	static const Entry *intern(const std::string &name);
+	const Entry *entry;
+};
+
+/** @}*/
+} // namespace crpropa
+
+#endif // CRPROPA_SYMBOL_H
@@ -136,6 +136,9 @@ public:
 
 	// All set field components
 	Vector3d getField(const Vector3d& pos) const;
+	void getFields(const Vector3d *positions, Vector3d *fields, size_t n,
+			double z = 0) const;
+	using MagneticField::getFields;
 };
 /** @} */
 
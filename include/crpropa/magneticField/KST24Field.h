@@ -122,6 +122,9 @@ private:
 
 public:
 	Vector3d getField(const Vector3d& pos) const;
+	void getFields(const Vector3d *positions, Vector3d *fields, size_t n,
+			double z = 0) const;
+	using MagneticField::getFields;
 	KST24Field();
 
 	Vector3d get_toroidal(const Vector3d pos_kpc, const double tor_B_gauss, 
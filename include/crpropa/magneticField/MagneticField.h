@@ -5,6 +5,8 @@
 #include "crpropa/Vector3.h"
 #include "crpropa/Referenced.h"
 
+#include <vector>
+
 #ifdef CRPROPA_HAVE_MUPARSER
 #include "muParser.h"
 #endif
@@ -29,6 +31,20 @@ public:
 	virtual Vector3d getField(const Vector3d &position, double z) const {
 		return getField(position);
 	};
+	/**
+	 Evaluates the field at n positions at once, e.g. all points of a grid row.
+	 The default implementation calls getField for each position; fields
+	 override it where evaluating a batch is faster.
+	 @param positions	array of n positions
+	 @param fields		array of n vectors receiving the field values
+	 @param n			number of positions
+	 @param z			redshift
+	 */
+	virtual void getFields(const Vector3d *positions, Vector3d *fields,
+			size_t n, double z = 0) const;
+	/** Evaluates the field at the given positions */
+	std::vector<Vector3d> getFields(const std::vector<Vector3d> &positions,
+			double z = 0) const;
 };
 
 /**
@@ -27,6 +27,9 @@ public:
 	void setGrid(ref_ptr<Grid3f> grid);
 	ref_ptr<Grid3f> getGrid();
 	Vector3d getField(const Vector3d &position) const;
+	void getFields(const Vector3d *positions, Vector3d *fields, size_t n,
+			double z = 0) const;
+	using MagneticField::getFields;
 };
 
 /**
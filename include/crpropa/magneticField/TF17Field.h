@@ -159,6 +159,9 @@ public:
     string getHaloModel() const;
 
 	Vector3d getField(const Vector3d& pos) const;
+	void getFields(const Vector3d *positions, Vector3d *fields, size_t n,
+			double z = 0) const;
+	using MagneticField::getFields;
 	Vector3d getDiskField(const double& r, const double& z, const double& phi, const double& sinPhi, const double& cosPhi) const;
 	Vector3d getHaloField(const double& r, const double& z, const double& phi, const double& sinPhi, const double& cosPhi) const;
 
@@ -50,6 +50,9 @@ public:
   UF23Field() = delete;
 
   Vector3d getField(const Vector3d& pos) const;
+  void getFields(const Vector3d *positions, Vector3d *fields, size_t n,
+                 double z = 0) const;
+  using MagneticField::getFields;
 
 private:
 
@@ -51,6 +51,20 @@ class GridTurbulence : public TurbulentField {
 	static void executeInverseFFTInplace(ref_ptr<Grid3f> grid,
 	                                     fftwf_complex *Bkx, fftwf_complex *Bky,
 	                                     fftwf_complex *Bkz);
+	// Same as above for a single component (0: x, 1: y, 2: z) of the grid
+	static void executeInverseFFTInplace(ref_ptr<Grid3f> grid,
+	                                     fftwf_complex *Bk, int component);
+
+	/** Number of threads used by the FFT, 0: number of OpenMP threads.
+	 Requires FFTW with thread support (fftw3f_omp or fftw3f_threads),
+	 otherwise the transform is single-threaded. */
+	static void setFFTThreads(int nThreads);
+	static int getFFTThreads();
+	/** File to import and export FFTW wisdom. If set, FFT plans are
+	 optimized once (FFTW_MEASURE) and reused by later grids of the same size,
+	 also across processes. An empty name disables the wisdom file. */
+	static void setFFTWisdomFile(const std::string &filename);
+	static std::string getFFTWisdomFile();
 
 	// Usefull checks for a grid field
 	/** Evaluate the mean vector of all grid points */
@@ -1,6 +1,7 @@
 #ifndef CRPROPA_PLANEWAVETURBULENCE_H
 #define CRPROPA_PLANEWAVETURBULENCE_H
 
+#include "crpropa/CpuFeatures.h"
 #include "crpropa/Grid.h"
 #include "crpropa/magneticField/turbulentField/TurbulentField.h"
 #include <vector>
@@ -40,13 +41,14 @@ implementation and matches the speed of trilinear interpolation on a grid at
 a bit less than 100 wavemodes. To do this, it uses special CPU instructions
 called AVX, which are unfortunately not supported by every CPU. On Linux, you
 can check whether your CPU supports AVX by using the `lscpu` command, and
-searching the flags section for the string "avx". Alternatively, if you are
-building on the same CPU that CRPropa will run on, you can have the compiler
-detect this for you automatically (see below).
+searching the flags section for the string "avx".
 
  An additional speedup of about 1.33 can be achieved if the CPU supports the
-FMA extension in addition to AVX. Again, you can either check for this
-manually, or have the compiler figure it out for you.
+AVX2 and FMA extensions in addition to AVX. CPUs supporting AVX-512 process
+eight wavemodes per instruction instead of four.
+
+ Evaluating several positions with one call of getFields (e.g. the stages of
+a Runge-Kutta step) avoids reloading the wavemode data for every position.
 
  **Note** that the optimized and non-optimized implementations to not return
 the exact same results. In fact, since the effective wave numbers used
@@ -56,34 +58,21 @@ of a double, but nevertheless relevant at some point), the wavemodes go
 out of phase for large distances from the origin, and the fields are no longer
 comparable at all.
 
- ### If you are building on the same machine that the code will run on:
+ ### Enabling the optimization
 
 1. In cmake: enable the FAST_WAVES flag.
-2. Also in cmake: set SIMD_EXTENSIONS to "native". The compiler will automatically
-detect support for your CPU and run the build with the appropriate settings.
-3. Generate files and exit cmake, then build.
-3. If your CPU does not support the necessary extensions, the build will fail
-with an error telling you so. In this case, you won't be able to use the optimization;
-go back into cmake, disable FAST_WAVES, and build again.
-4. If the build runs through without errors, the code is built with the optimization.
-
- ### If you are building on a different machine from the one where the code will run:
-
-1. Figure out which extensions your target machine supports, using `lscpu | grep avx`
-for AVX, and `lscpu | grep fma` for FMA. Run these commands on your target machine,
-not on your build machine. If your target machine does not run Linux, you may have to
-use different commands.
-2. If the CPU does not support AVX, you can stop here, and build normally. The CPU
-does not support the necessary extensions, and will not run code that is compiled
-using them.
-3. If the CPU does support AVX, continue. In cmake, enable the FAST_WAVES flag.
-4. Also in cmake, set SIMD_EXTENSIONS to the appropriate value. If your target CPU
-supports only AVX, but not FMA, set it to "avx". If it supports both, set it to
-"avx+fma".
-5. Generate and exit cmake, then build.
-6. If you made a mistake and used the wrong flags, you should see an illegal
-instruction error when trying to import CRPropa, or (at the latest) when trying
-to call `getField`.
+2. Generate files and exit cmake, then build.
+
+ With GCC and Clang on x86, the AVX, AVX2+FMA and AVX-512 kernels are always compiled,
+and the fastest one supported by the CPU is selected at runtime when the field
+is created (see cpuSimdLevel). The same build thus runs on all machines of a
+cluster; on CPUs without AVX, the non-optimized implementation is used and a
+warning is printed. setMaximumSimdLevel(SIMD_NONE) before creating the field
+selects the non-optimized implementation on any CPU.
+
+ With other compilers, SIMD_EXTENSIONS has to be set to "avx", "avx+fma", or
+"native" in cmake, and the build fails with an error otherwise. The code then
+only runs on CPUs supporting these extensions.
 
 [GJ99]: https://doi.org/10.1086/307452
 [TD13]: https://doi.org/10.1063/1.4789861
@@ -118,6 +107,8 @@ class PlaneWaveTurbulence : public TurbulentField {
 	static const int ikkappa2 = 5;
 	static const int ibeta = 6;
 	static const int itotal = 7;
+	// kernel selected at construction
+	SimdLevel simdLevel;
 
   public:
 	/**
@@ -141,6 +132,19 @@ class PlaneWaveTurbulence : public TurbulentField {
 	   Theoretical runtime is O(Nm), where Nm is the number of wavemodes.
 	*/
 	Vector3d getField(const Vector3d &pos) const;
+
+	/**
+	   Evaluates the field at n positions at once. With FAST_WAVES, each block
+	   of wavemodes is loaded once for up to four positions, which is faster
+	   than n calls of getField.
+	   @param positions	array of n positions
+	   @param fields	array of n vectors receiving the field values
+	   @param n		number of positions
+	   @param z		redshift (not used)
+	*/
+	void getFields(const Vector3d *positions, Vector3d *fields, size_t n,
+	               double z = 0) const;
+	using MagneticField::getFields;
 };
 
 /** @} */
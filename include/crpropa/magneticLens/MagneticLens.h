@@ -28,6 +28,8 @@
 #include "crpropa/Units.h"
 #include "crpropa/Vector3.h"
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <string>
 #include <stdexcept>
@@ -40,7 +42,8 @@
 namespace crpropa
 {
 
-/// Holds one matrix for the lens and information about the rigidity range
+/// Holds one matrix for the lens and information about the rigidity range.
+/// The matrix is loaded from file when it is first used.
 class LensPart
 {
 	string _filename;
@@ -49,16 +52,20 @@ class LensPart
 	ModelMatrixType M;
 	double _maximumSumOfColumns;
 	bool _maximumSumOfColumns_calculated;
+	// cumulative sums of the values in each column, in the order of the
+	// compressed storage of M
+	std::vector<double> _columnCDF;
+	std::atomic<bool> _loaded;
 
 public:
-	LensPart()
+	LensPart() : _loaded(false)
 	{
 	}
 	/// File containing the matrix to be used in the range rigidityMin,
 	/// rigidityMax in Joule
 	LensPart(const std::string &filename, double rigidityMin, double rigidityMax) :
 			_filename(filename), _rigidityMin(rigidityMin), _rigidityMax(rigidityMax), _maximumSumOfColumns_calculated(
-					false), _maximumSumOfColumns(0)
+					false), _maximumSumOfColumns(0), _loaded(false)
 	{
 	}
 
@@ -70,6 +77,39 @@ public:
 	void loadMatrixFromFile()
 	{
 		deserialize(_filename, M);
+		updateColumnCDF();
+		_loaded = true;
+	}
+
+	/// Loads the matrix from file unless it is loaded already. Thread safe.
+	void ensureLoaded()
+	{
+		if (_loaded)
+			return;
+		// exceptions must not leave the critical section
+		bool failed = false;
+		std::string error;
+#pragma omp critical(LensPart)
+		if (!_loaded)
+		{
+			try
+			{
+				loadMatrixFromFile();
+			}
+			catch (std::exception &e)
+			{
+				failed = true;
+				error = e.what();
+			}
+		}
+		if (failed)
+			throw std::runtime_error(error);
+	}
+
+	/// Returns true if the matrix is loaded or was set directly
+	bool isLoaded() const
+	{
+		return _loaded;
 	}
 
 	/// Returns the filename of the matrix
@@ -83,7 +123,7 @@ public:
 	{
 		if (!_maximumSumOfColumns_calculated)
 		{ // lazy calculation of maximum
-			_maximumSumOfColumns = maximumOfSumsOfColumns(M);
+			_maximumSumOfColumns = maximumOfSumsOfColumns(getMatrix());
 			_maximumSumOfColumns_calculated = true;
 		}
 		return _maximumSumOfColumns;
@@ -101,9 +141,10 @@ public:
 		return _rigidityMax / eV;
 	}
 
-	/// Returns the modelmatrix
+	/// Returns the modelmatrix, loading it if necessary
 	ModelMatrixType& getMatrix()
 	{
+		ensureLoaded();
 		return M;
 	}
 
@@ -111,6 +152,51 @@ public:
 	void setMatrix(const ModelMatrixType& m)
 	{
 		M = m;
+		updateColumnCDF();
+		_loaded = true;
+	}
+
+	/// Calculates the cumulative sums of the matrix columns used by sampleRow.
+	/// Has to be called after the matrix returned by getMatrix is modified.
+	void updateColumnCDF()
+	{
+		M.makeCompressed();
+		_columnCDF.resize(M.nonZeros());
+		const double *values = M.valuePtr();
+		const ModelMatrixType::StorageIndex *outer = M.outerIndexPtr();
+		for (size_t c = 0; c < (size_t) M.cols(); c++)
+		{
+			double cpv = 0;
+			for (size_t k = outer[c]; k < (size_t) outer[c + 1]; k++)
+			{
+				cpv += values[k];
+				_columnCDF[k] = cpv;
+			}
+		}
+	}
+
+	/// Throws if the matrix was changed without updateColumnCDF, as far as
+	/// this can be seen from the number of entries and the storage
+	void checkColumnCDF() const
+	{
+		if ((_columnCDF.size() != (size_t) M.nonZeros()) || !M.isCompressed())
+			throw std::runtime_error("LensPart: matrix was modified, call updateColumnCDF");
+	}
+
+	/// Returns the row of the first entry in the given column for which the
+	/// cumulative sum of the column exceeds rn, or -1 if rn is not smaller
+	/// than the sum of the column. Binary search, no allocation. The matrix
+	/// has to be loaded (see ensureLoaded).
+	long sampleRow(size_t column, double rn) const
+	{
+		checkColumnCDF();
+		const ModelMatrixType::StorageIndex *outer = M.outerIndexPtr();
+		const double *begin = _columnCDF.data() + outer[column];
+		const double *end = _columnCDF.data() + outer[column + 1];
+		const double *i = std::upper_bound(begin, end, rn);
+		if (i == end)
+			return -1;
+		return M.innerIndexPtr()[i - _columnCDF.data()];
 	}
 
 
@@ -159,6 +245,7 @@ class MagneticLens
 	// Checks Matrix, raises Errors if not ok - also generate
 	// _pixelization if called first time
 	void _checkMatrix(const ModelMatrixType &M);
+	void _checkMatrixSize(uint32_t rows, uint32_t cols);
 	// minimum / maximum rigidity that is covered by the lens [Joule]
 	double _minimumRigidity;
 	double _maximumRigidity;
@@ -208,16 +295,30 @@ public:
 	/// Try to transform the comsic ray to a new direction.
 	/// Returns false and does not change phi and theta if the cosmic ray is
 	/// lost due to conservation of cosmic ray flux.
-	/// Rigidity is given in Joule, phi and theta in rad
-	bool transformCosmicRay(double rigidity, double& phi, double& theta);
+	/// Rigidity is given in Joule, phi and theta in rad.
+	/// The target pixel is found by a binary search in the cumulative column
+	/// of the lens part, so that the method is thread safe and does not
+	/// allocate memory.
+	bool transformCosmicRay(double rigidity, double& phi, double& theta) const;
 
 	/// Tries transform a cosmic ray with momentum vector p
-	bool transformCosmicRay(double rigidity, Vector3d &p);
+	bool transformCosmicRay(double rigidity, Vector3d &p) const;
+
+	/// Transforms n cosmic rays of the same rigidity [Joule] in parallel.
+	/// survived[i] is set to false for lost cosmic rays, whose phi[i] and
+	/// theta[i] are not changed. Returns the number of surviving cosmic rays.
+	size_t transformCosmicRays(double rigidity, double *phi, double *theta,
+			bool *survived, size_t n) const;
 
 	/// transforms the model array assuming that model points to an array of the
 	/// correct size. Rigidity is given in Joule
 	void transformModelVector(double* model, double rigidity) const;
 
+	/// transforms nVectors model arrays stored one after the other in models,
+	/// each of the size of the pixelization, in parallel. Rigidity is given in
+	/// Joule
+	void transformModelVectors(double* models, size_t nVectors, double rigidity) const;
+
 	/// Loads M as part of a lens and use it in given rigidity range with
 	/// rigidities given in Joule
 	void setLensPart(const ModelMatrixType &M, double rigidityMin, double rigidityMax);
@@ -225,6 +326,8 @@ public:
 	/// Loads a lens from a given file, containing lines like
 	/// lensefile.MLDAT rigidityMin rigidityMax
 	/// rigidities are given in logarithmic units [log10(E / eV)]
+	/// Only the size of the matrices is read; each matrix is loaded when its
+	/// rigidity range is first used.
 	void loadLens(const string &filename);
 
 	/// Normalizes the lens parts to the maximum of sums of columns of
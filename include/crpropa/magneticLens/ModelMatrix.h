@@ -49,9 +49,20 @@ namespace crpropa
 	/// (Int, Int, Double) : (column, row, value) triples ...
 	void serialize(const string &filename, const ModelMatrixType &matrix);
 
-	/// Reads a matrix from file
+	/// Writes the ModelMatrix to disk in the compressed column layout of
+	/// ModelMatrixType, which is read without sorting or conversion:
+	/// char[8] "CRPCSC", UInt32 (version), UInt32 (reserved),
+	/// UInt64 (rows), UInt64 (columns), UInt64 (number of non zero elements),
+	/// Int32 column offsets (columns + 1), Int32 row indices, Double values
+	void serializeCompressed(const string &filename, const ModelMatrixType &matrix);
+
+	/// Reads a matrix from file, written by serialize or serializeCompressed
 	void deserialize(const string &filename, ModelMatrixType &matrix);
 
+	/// Reads only the size of a matrix from file, written by serialize or
+	/// serializeCompressed
+	void deserializeSize(const string &filename, uint32_t &rows, uint32_t &columns);
+
 	/// Normalizes each column j of the matrix so that, \f$ \Vert m_j \Vert_1 = 1 \f$ 
 	void normalizeColumns(ModelMatrixType &matrix);
 
@@ -64,6 +75,10 @@ namespace crpropa
 
 	// matrix vector product with update: model = matrix * model
 	void prod_up(const ModelMatrixType& matrix, double* model);
+
+	/// Matrix product with update for nVectors consecutive model vectors of
+	/// size matrix.cols(), parallelized over blocks of vectors
+	void prod_up(const ModelMatrixType& matrix, double* models, size_t nVectors);
 } // namespace parsec
 
 #endif // MODELMATRIX_HH
@@ -20,10 +20,21 @@ namespace crpropa {
 
  The maps are stored with discrete energies on a logarithmic scale. The
  default energy width is 0.02 with an energy bin from 10**17.99 - 10**18.01 eV.
+
+ For drawing random particles, cumulative sums over all maps and over the
+ pixels of each map are kept, so that a particle is drawn by two binary
+ searches. The tables take as much memory as the maps themselves.
  */
 class ParticleMapsContainer {
 private:
-	std::map<int, std::map <int, double*> > _data;
+	// map of one particle id and energy bin
+	struct ParticleMap {
+		int pid;
+		int energyIdx;
+		double *data;
+	};
+	// all maps, sorted by particle id and energy bin
+	std::vector<ParticleMap> _maps;
 	Pixelization _pixelization;
 	double _deltaLogE;
 	double _bin0lowerEdge;
@@ -32,15 +43,23 @@ private:
 	int energy2Idx(double energy) const;
 	double idx2Energy(int idx) const;
 
+	// index of the map in _maps, -1 if there is none
+	long findMap(int pid, int energyIdx) const;
+	static bool mapBefore(const ParticleMap &m, const std::pair<int, int> &key);
+
 	// weights of the particles
 	double _sumOfWeights;
-	std::map<int, double > _weightsPID;
-	std::map<int, map<int, double> > _weights_pidEnergy;
+	std::vector<double> _weights; // sum of each map
+	std::vector<double> _cumulativeWeights; // cumulative sum over the maps
+	std::vector<double> _cumulativePixels; // cumulative sum over the pixels of each map
 
 	// lazy update of weights
 	bool _weightsUpToDate;
 	void _updateWeights();
 
+	// draw a direction from the map with the given index, requires up to date weights
+	bool _placeOnMap(size_t mapIdx, double &galacticLongitude, double &galacticLatitude);
+
 public:
 	/** Constructor.
 	 @param deltaLogE		width of logarithmic energy bin [in eV]
@@ -92,7 +111,7 @@ public:
 
 	void applyLens(MagneticLens &lens);;
 
-	/** Get random particles from map.
+	/** Get random particles from map, drawn in parallel.
 	 The arguments are the vectors where the information will be stored.
 	 @param N					number of particles to be selected
 	 @param particleId			id of the particle following the PDG numbering scheme
@@ -135,7 +154,8 @@ public:
 	double getWeight(int pid, double energy) {
 		if (!_weightsUpToDate)
 			_updateWeights();
-		return _weights_pidEnergy[pid][energy2Idx(energy)];
+		long i = findMap(pid, energy2Idx(energy));
+		return (i < 0) ? 0. : _weights[i];
 	}
 };
 /** @}*/
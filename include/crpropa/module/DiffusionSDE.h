@@ -66,6 +66,8 @@ public:
 	void process(crpropa::Candidate *candidate) const;
 
 	void tryStep(const Vector3d &Pos, Vector3d &POut, Vector3d &PosErr, double z, double propStep ) const;
+	/** Same as above, with the magnetic field BIn at the initial position Pos already known */
+	void tryStep(const Vector3d &Pos, const Vector3d &BIn, Vector3d &POut, Vector3d &PosErr, double z, double propStep) const;
 	void driftStep(const Vector3d &Pos, Vector3d &LinProp, double h, double t) const;
 	void calculateBTensor(double rig, double BTen[], Vector3d pos, Vector3d dir, double z) const;
 
@@ -92,6 +94,8 @@ public:
 	 @param z	 current redshift is needed to calculate the magnetic field
 	 @return	  magnetic field vector at the position pos */
 	Vector3d getMagneticFieldAtPosition(Vector3d pos, double z) const;
+	/** Same as above, using the per-step field cache of the candidate (see Candidate::getMagneticField) */
+	Vector3d getMagneticFieldAtPosition(Vector3d pos, double z, Candidate *candidate) const;
 	ref_ptr<AdvectionField> getAdvectionField() const;
 	/** get advection field vector at current candidate position
 	 @param pos   current position of the candidate
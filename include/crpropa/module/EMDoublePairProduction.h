@@ -30,7 +30,7 @@ private:
 	bool haveElectrons;
 	double limit;
 	double thinning;
-	std::string interactionTag = "EMDP";
+	Symbol interactionTag = Symbol("EMDP");
 
 	// tabulated interaction rate 1/lambda(E)
 	std::vector<double> tabEnergy;  //!< electron energy in [J]
@@ -32,7 +32,7 @@ private:
 	bool haveElectrons;					// add secondary electrons to simulation
 	double limit;						// limit the step to a fraction of the mean free path
 	double thinning;					// factor of the thinning (0: no thinning, 1: maximum thinning)
-	std::string interactionTag = "EMPP";
+	Symbol interactionTag = Symbol("EMPP");
 
 	// tabulated interaction rate 1/lambda(E)
 	std::vector<double> tabEnergy;  //!< electron energy in [J]
@@ -18,7 +18,7 @@ private:
 
 	std::vector<double> tabRate; // elastic scattering rate
 	std::vector<std::vector<double> > tabCDF; // CDF as function of background photon energy
-	std::string interactionTag = "ES";
+	Symbol interactionTag = Symbol("ES");
 
 	static const double lgmin; // minimum log10(Lorentz-factor)
 	static const double lgmax; // maximum log10(Lorentz-factor)
@@ -7,6 +7,9 @@
 #include "crpropa/module/Output.h"
 #include <stdint.h>
 #include <ctime>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <H5Ipublic.h>
 
@@ -97,6 +100,21 @@ class HDF5Output: public Output {
 	time_t lastFlush;
 	unsigned int flushLimit;
 	unsigned int candidatesSinceFlush;
+
+	// asynchronous writing: full buffers are swapped into writeBuffer and
+	// written to disk by a dedicated writer thread
+	bool asyncWrite;
+	mutable std::vector<OutputRow> writeBuffer;
+	mutable std::mutex writerMutex;
+	mutable std::condition_variable writerCondition;
+	std::thread writerThread;
+	bool stopWriter;
+
+	mutable ThreadBuffer<OutputRow> threadBuffer;
+
+	void appendRows(const std::vector<OutputRow> &rows) const;
+	void writeRows(const std::vector<OutputRow> &rows) const;
+	void writerLoop();
 public:
 	/** Default constructor.
 	  	Does not run from scratch.
@@ -126,6 +144,12 @@ public:
 	/// with frequent output this should be set to a high number (default)
 	void setFlushLimit(unsigned int N);
 
+	/// Write the buffered rows from a dedicated writer thread. Full buffers
+	/// are handed over to the writer, so that the processing threads do not
+	/// wait for the disk I/O. Has to be set before the file is opened.
+	void setAsyncWrite(bool async);
+	bool isAsyncWrite() const;
+
 	/** Create and prepare a file as HDF5-file.
 	 */
 	void open(const std::string &filename);
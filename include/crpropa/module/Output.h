@@ -57,6 +57,7 @@ public:
 	struct Property
 	{
 		std::string name;
+		Symbol symbol; // interned name for the property lookup
 		std::string comment;
 		Variant defaultValue;
 	};
@@ -69,8 +70,11 @@ protected:
 
 	bool oneDimensional;
 	mutable size_t count;
+	size_t threadBufferSize;
 
 	void modify();
+	/// True if the calling thread collects its rows in a thread buffer
+	bool useThreadBuffer() const;
 
 public:
 	enum OutputColumn {
@@ -172,6 +176,21 @@ public:
 	/** Returns the size of the output
 	 */
 	size_t size() const;
+	/** Number of rows each thread collects in its own buffer before they are
+	 handed over to the output. This avoids taking the output lock for every
+	 candidate. Only threads of an OpenMP parallel region, e.g. in ModuleList::run,
+	 use the buffers, rows from other threads are written directly.
+	 Rows still held by the threads are written on close, not at the end of
+	 ModuleList::run.
+	 @param rows	number of rows per thread; 0 or 1 writes every row directly (default)
+	 */
+	void setThreadBufferSize(size_t rows);
+	size_t getThreadBufferSize() const;
+
+	/// Maximum number of OpenMP threads supported by the per-thread buffers
+	static const size_t maxThreads = 256;
+	/// Index of the calling thread in the current OpenMP team
+	static size_t getThreadIndex();
 
 	void process(Candidate *) const;
 
@@ -188,6 +207,44 @@ public:
 	};
 };
 
+/**
+ @class ThreadBuffer
+ @brief Per-thread staging buffers for Output modules.
+ Each OpenMP thread fills its own chunk, which is handed over to the
+ output only when it is full (see Output::setThreadBufferSize).
+ */
+template<typename T>
+class ThreadBuffer {
+public:
+	struct Chunk {
+		std::vector<T> data;
+		size_t rows;
+		// keep chunks of different threads on separate cache lines
+		char padding[64];
+		Chunk() : rows(0) {}
+		void clear() {
+			data.clear();
+			rows = 0;
+		}
+	};
+
+	ThreadBuffer() : chunks(Output::maxThreads) {}
+
+	/// chunk of the calling thread
+	Chunk &local() {
+		return chunks[Output::getThreadIndex()];
+	}
+	Chunk &operator[](size_t i) {
+		return chunks[i];
+	}
+	size_t size() const {
+		return chunks.size();
+	}
+
+private:
+	std::vector<Chunk> chunks;
+};
+
 /** @}*/
 
 } // namespace crpropa
@@ -37,7 +37,7 @@ public:
  */
 class ShellPropertyOutput: public Module {
 public:
-	typedef Loki::AssocVector<std::string, Variant> PropertyMap;
+	typedef Loki::AssocVector<Symbol, Variant> PropertyMap;
 	void process(Candidate *candidate) const;
 	std::string getDescription() const;
 };
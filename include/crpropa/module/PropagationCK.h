@@ -51,7 +51,6 @@ public:
 	};
 
 private:
-	std::vector<double> a, b, bs; /*< Cash-Karp coefficients */
 	ref_ptr<MagneticField> field;
 	double tolerance; /*< target relative error of the numerical integration */
 	double minStep; /*< minimum step size of the propagation */
@@ -72,10 +71,19 @@ public:
 	// derivative of phase point, dY/dt = d/dt(x, u) = (v, du/dt)
 	// du/dt = q*c^2/E * (u x B)
 	Y dYdt(const Y &y, ParticleState &p, double z) const;
+	/// Same as above, with the field B at the phase point already known
+	Y dYdt(const Y &y, ParticleState &p, const Vector3d &B) const;
 
 	void tryStep(const Y &y, Y &out, Y &error, double t,
 			ParticleState &p, double z) const;
 
+	/** Perform one Cash-Karp step with a precomputed first stage.
+	 * @param y		initial phase point
+	 * @param k0	derivative at the initial phase point, dYdt(y, p, z)
+	 */
+	void tryStep(const Y &y, const Y &k0, Y &out, Y &error, double t,
+			ParticleState &p, double z) const;
+
 	void setField(ref_ptr<MagneticField> field);
 	void setTolerance(double tolerance);
 	void setMinimumStep(double minStep);
@@ -89,6 +97,8 @@ public:
 	 * @param z	 current redshift is needed to calculate the magnetic field
 	 * @return	  magnetic field vector at the position pos */
 	Vector3d getFieldAtPosition(Vector3d pos, double z) const;
+	/** Same as above, using the per-step field cache of the candidate (see Candidate::getMagneticField) */
+	Vector3d getFieldAtPosition(Vector3d pos, double z, Candidate *candidate) const;
 
 	double getTolerance() const;
 	double getMinimumStep() const;
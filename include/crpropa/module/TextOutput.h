@@ -25,8 +25,11 @@ protected:
 	std::ofstream outfile;
 	std::string filename;
 	bool storeRandomSeeds;
+	mutable ThreadBuffer<char> threadBuffer;
 	
 	void printHeader() const;
+	void write(const char *data, size_t size, size_t rows) const;
+	void flushThreadBuffers();
 
 public:
 	/** Default constructor
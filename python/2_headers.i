@@ -35,6 +35,19 @@
 %ignore operator crpropa::SourceInterface*;
 %ignore operator crpropa::SourceFeature*;
 %ignore operator crpropa::Candidate*;
+%ignore crpropa::Candidate::operator new;
+%ignore crpropa::Candidate::getTagSymbol;
+%ignore crpropa::Candidate::setTagOrigin(const Symbol &);
+%ignore crpropa::Candidate::setProperty(const Symbol &, const Variant &);
+%ignore crpropa::Candidate::getProperty(const Symbol &) const;
+%ignore crpropa::Candidate::removeProperty(const Symbol &);
+%ignore crpropa::Candidate::hasProperty(const Symbol &) const;
+%ignore crpropa::Candidate::addSecondary(int, double, double, const Symbol &);
+%ignore crpropa::Candidate::addSecondary(int, double, Vector3d, double, const Symbol &);
+%ignore crpropa::Output::Property::symbol;
+%ignore crpropa::Candidate::operator delete;
+%ignore crpropa::Candidate::getMagneticField;
+%ignore *::getFields(const Vector3d *, Vector3d *, size_t, double) const;
 %ignore operator crpropa::Module*;
 %ignore operator crpropa::ModuleList*;
 %ignore operator crpropa::Observer*;
@@ -50,6 +63,9 @@
 %ignore operator crpropa::Grid< crpropa::Vector3< double > >*;
 %ignore operator crpropa::Grid< float >*;
 %ignore operator crpropa::Grid< double >*;
+%ignore crpropa::GridMapping;
+%ignore crpropa::Grid::Grid(const GridProperties &, ref_ptr<GridMapping>, size_t);
+%ignore crpropa::Grid::operator=;
 %ignore crpropa::TextOutput::load;
 
 %feature("ref")   crpropa::Referenced "$this->addReference();"
@@ -121,13 +137,20 @@
 
 %template(Vector3d) crpropa::Vector3<double>;
 %template(Vector3f) crpropa::Vector3<float>;
+%template(Vector3dVector) std::vector< crpropa::Vector3<double> >;
 
 %include "crpropa/Referenced.h"
 %include "crpropa/Units.h"
 %include "crpropa/Common.h"
 %include "crpropa/Cosmology.h"
+%include "crpropa/CpuFeatures.h"
+%ignore crpropa::DataTable::row;
+%ignore crpropa::DataTable::data;
+%template(DataTableRefPtr) crpropa::ref_ptr<crpropa::DataTable>;
+%include "crpropa/DataTable.h"
 %template(RandomSeed) std::vector<uint32_t>;
 %template(RandomSeedThreads) std::vector< std::vector<uint32_t> >;
+%ignore crpropa::Random::randBin(const double *, size_t);
 %include "crpropa/Random.h"
 %include "crpropa/ParticleState.h"
 %include "crpropa/ParticleID.h"
@@ -15,6 +15,7 @@
   #include "crpropa/magneticLens/ParticleMapsContainer.h"
 %}
 
+%apply uint32_t &OUTPUT {uint32_t &rows, uint32_t &columns};
 %include "crpropa/magneticLens/ModelMatrix.h"
 %apply double &INOUT {double &longitude, double &latitude};
 %typemap(in,numinputs=0) double& longitude (double temp) "$1 = &temp;"
@@ -34,6 +35,9 @@
 
 %apply double &INOUT {double &phi, double &theta};
 %ignore MagneticLens::transformModelVector(double *, double) const;
+%ignore MagneticLens::transformModelVectors;
+%ignore MagneticLens::transformCosmicRays;
+%ignore LensPart::sampleRow;
 %include "crpropa/magneticLens/MagneticLens.h"
 %template(LenspartVector) std::vector<crpropa::LensPart*>;
 
@@ -45,16 +49,40 @@
     int ndim = 0;
     npy_intp dims[NPY_MAXDIMS];
     if (PyArray_GetArrayParamsFromObject(input, NULL, 1, &dtype, &ndim, dims, &arr, NULL) < 0) {
-      Py_RETURN_NONE;
+      return NULL;
     }
 
     if (arr == NULL) {
-      Py_RETURN_NONE;
+      throw std::runtime_error("MagneticLens::transformModelVector - require numpy array as input");
+    }
+
+    // a 2-D array holds one model vector per row
+    ndim = PyArray_NDIM(arr);
+    if ((ndim < 1) || (ndim > 2) || !PyArray_IS_C_CONTIGUOUS(arr)) {
+      Py_DECREF(arr);
+      throw std::runtime_error("MagneticLens::transformModelVector - require C-contiguous 1-D or 2-D array");
+    }
+    if (PyArray_TYPE(arr) != NPY_DOUBLE) {
+      Py_DECREF(arr);
+      throw std::runtime_error("MagneticLens::transformModelVector - require array of type float64");
+    }
+    // the model vectors are transformed in place
+    if (!PyArray_ISWRITEABLE(arr)) {
+      Py_DECREF(arr);
+      throw std::runtime_error("MagneticLens::transformModelVector - require writeable array");
+    }
+    npy_intp *shape = PyArray_DIMS(arr);
+    crpropa::LensPart *lenspart = $self->getLensPart(rigidity);
+    if (lenspart && (shape[ndim - 1] != lenspart->getMatrix().cols())) {
+      Py_DECREF(arr);
+      throw std::runtime_error("MagneticLens::transformModelVector - length of the model vectors does not match the lens");
     }
+    size_t nVectors = (ndim == 2) ? shape[0] : 1;
 
     double *dataPointer = (double*) PyArray_DATA(arr);
-    $self->transformModelVector(dataPointer, rigidity);
-    return input;
+    $self->transformModelVectors(dataPointer, nVectors, rigidity);
+    // arr is a new reference to the input array
+    return (PyObject*) arr;
   }
 };
 
@@ -1,44 +1,25 @@
 #include "crpropa/Candidate.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/Units.h"
+#include "crpropa/magneticField/MagneticField.h"
 
 #include <stdexcept>
 
 namespace crpropa {
 
 Candidate::Candidate(int id, double E, Vector3d pos, Vector3d dir, double z, double weight, std::string tagOrigin) :
-  redshift(z), trajectoryLength(0), weight(weight), currentStep(0), nextStep(0), active(true), parent(0), tagOrigin(tagOrigin), time(0) {
+  redshift(z), trajectoryLength(0), weight(weight), currentStep(0), nextStep(0), active(true), parent(0), tagOrigin(tagOrigin), time(0), cachedField(0) {
 	ParticleState state(id, E, pos, dir);
 	source = state;
 	created = state;
 	previous = state;
 	current = state;
-
-#if defined(OPENMP_3_1)
-		#pragma omp atomic capture
-		{serialNumber = nextSerialNumber++;}
-#elif defined(__GNUC__)
-		{serialNumber = __sync_add_and_fetch(&nextSerialNumber, 1);}
-#else
-		#pragma omp critical(serialNumber)
-		{serialNumber = nextSerialNumber++;}
-#endif
-
+	serialNumber = allocateSerialNumber();
 }
 
 Candidate::Candidate(const ParticleState &state) :
-		source(state), created(state), current(state), previous(state), redshift(0), trajectoryLength(0), currentStep(0), nextStep(0), active(true), parent(0), tagOrigin ("PRIM"), time(0) {
-
-#if defined(OPENMP_3_1)
-		#pragma omp atomic capture
-		{serialNumber = nextSerialNumber++;}
-#elif defined(__GNUC__)
-		{serialNumber = __sync_add_and_fetch(&nextSerialNumber, 1);}
-#else
-		#pragma omp critical(serialNumber)
-		{serialNumber = nextSerialNumber++;}
-#endif
-
+		source(state), created(state), current(state), previous(state), redshift(0), trajectoryLength(0), currentStep(0), nextStep(0), active(true), parent(0), tagOrigin ("PRIM"), time(0), cachedField(0) {
+	serialNumber = allocateSerialNumber();
 }
 
 bool Candidate::isActive() const {
@@ -103,15 +84,37 @@ void Candidate::limitNextStep(double step) {
 	nextStep = std::min(nextStep, step);
 }
 
+Vector3d Candidate::getMagneticField(const MagneticField *field, const Vector3d &position, double z) {
+	if ((field != cachedField) || !(position == cachedFieldPosition) || (z != cachedFieldRedshift)) {
+		cachedFieldValue = field->getField(position, z);
+		cachedField = field;
+		cachedFieldPosition = position;
+		cachedFieldRedshift = z;
+	}
+	return cachedFieldValue;
+}
+
 void Candidate::setProperty(const std::string &name, const Variant &value) {
+	setProperty(Symbol(name), value);
+}
+
+void Candidate::setProperty(const Symbol &name, const Variant &value) {
 	properties[name] = value;
 }
 
 void Candidate::setTagOrigin (std::string tagOrigin) {
+	this->tagOrigin = Symbol(tagOrigin);
+}
+
+void Candidate::setTagOrigin(const Symbol &tagOrigin) {
 	this->tagOrigin = tagOrigin;
 }
 
-std::string Candidate::getTagOrigin () const {
+const std::string &Candidate::getTagOrigin () const {
+	return tagOrigin.str();
+}
+
+const Symbol &Candidate::getTagSymbol() const {
 	return tagOrigin;
 }
 
@@ -124,13 +127,21 @@ double Candidate::getTime() const {
 }
 
 const Variant &Candidate::getProperty(const std::string &name) const {
+	return getProperty(Symbol(name));
+}
+
+const Variant &Candidate::getProperty(const Symbol &name) const {
 	PropertyMap::const_iterator i = properties.find(name);
 	if (i == properties.end())
-		throw std::runtime_error("Unknown candidate property: " + name);
+		throw std::runtime_error("Unknown candidate property: " + name.str());
 	return i->second;
 }
 
 bool Candidate::removeProperty(const std::string& name) {
+	return removeProperty(Symbol(name));
+}
+
+bool Candidate::removeProperty(const Symbol &name) {
 	PropertyMap::iterator i = properties.find(name);
 	if (i == properties.end())
 		return false;
@@ -139,6 +150,10 @@ bool Candidate::removeProperty(const std::string& name) {
 }
 
 bool Candidate::hasProperty(const std::string &name) const {
+	return hasProperty(Symbol(name));
+}
+
+bool Candidate::hasProperty(const Symbol &name) const {
 	PropertyMap::const_iterator i = properties.find(name);
 	if (i == properties.end())
 		return false;
@@ -150,15 +165,17 @@ void Candidate::addSecondary(Candidate *c) {
 }
 
 void Candidate::addSecondary(int id, double energy, double w, std::string tagOrigin) {
+	addSecondary(id, energy, w, Symbol(tagOrigin));
+}
+
+void Candidate::addSecondary(int id, double energy, double w, const Symbol &tagOrigin) {
 	ref_ptr<Candidate> secondary = new Candidate;
 	secondary->setRedshift(redshift);
 	secondary->setTrajectoryLength(trajectoryLength);
 	secondary->setTime(time);
 	secondary->setWeight(weight * w);
 	secondary->setTagOrigin(tagOrigin);
-	for (PropertyMap::const_iterator it = properties.begin(); it != properties.end(); ++it) {
-		secondary->setProperty(it->first, it->second);		
-	}
+	secondary->properties = properties;
 	secondary->source = source;
 	secondary->previous = previous;
 	secondary->created = previous;
@@ -170,15 +187,17 @@ void Candidate::addSecondary(int id, double energy, double w, std::string tagOri
 }
 
 void Candidate::addSecondary(int id, double energy, Vector3d position, double w, std::string tagOrigin) {
+	addSecondary(id, energy, position, w, Symbol(tagOrigin));
+}
+
+void Candidate::addSecondary(int id, double energy, Vector3d position, double w, const Symbol &tagOrigin) {
 	ref_ptr<Candidate> secondary = new Candidate;
 	secondary->setRedshift(redshift);
 	secondary->setTrajectoryLength(trajectoryLength - (current.getPosition() - position).getR());
 	secondary->setTime(time - (current.getPosition() - position).getR() / getVelocity());
 	secondary->setWeight(weight * w);
 	secondary->setTagOrigin(tagOrigin);
-	for (PropertyMap::const_iterator it = properties.begin(); it != properties.end(); ++it) {
-		secondary->setProperty(it->first, it->second);		
-	}
+	secondary->properties = properties;
 	secondary->source = source;
 	secondary->previous = previous;
 	secondary->created = previous;
@@ -253,13 +272,106 @@ uint64_t Candidate::getCreatedSerialNumber() const {
 
 void Candidate::setNextSerialNumber(uint64_t snr) {
 	nextSerialNumber = snr;
+	// discard the serial numbers already handed out to the threads
+	serialNumberGeneration++;
 }
 
 uint64_t Candidate::getNextSerialNumber() {
 	return nextSerialNumber;
 }
 
+void Candidate::setSerialNumberBlockSize(uint64_t size) {
+	if (size == 0)
+		throw std::runtime_error("Candidate: serial number block size must be positive");
+	serialNumberBlockSize = size;
+	serialNumberGeneration++;
+}
+
+uint64_t Candidate::getSerialNumberBlockSize() {
+	return serialNumberBlockSize;
+}
+
 uint64_t Candidate::nextSerialNumber = 0;
+uint64_t Candidate::serialNumberBlockSize = 1;
+uint64_t Candidate::serialNumberGeneration = 0;
+
+namespace {
+// range of serial numbers reserved by the current thread
+struct SerialNumberBlock {
+	uint64_t next;
+	uint64_t end;
+	uint64_t generation;
+};
+thread_local SerialNumberBlock serialNumberBlock = {0, 0, 0};
+} // namespace
+
+uint64_t Candidate::allocateSerialNumber() {
+	SerialNumberBlock &block = serialNumberBlock;
+	if ((block.next == block.end) || (block.generation != serialNumberGeneration)) {
+		uint64_t size = serialNumberBlockSize;
+		uint64_t last;
+#if defined(OPENMP_3_1)
+		#pragma omp atomic capture
+		{nextSerialNumber += size; last = nextSerialNumber;}
+#elif defined(__GNUC__)
+		{last = __sync_add_and_fetch(&nextSerialNumber, size);}
+#else
+		#pragma omp critical(serialNumber)
+		{nextSerialNumber += size; last = nextSerialNumber;}
+#endif
+		block.next = last - size + 1;
+		block.end = last + 1;
+		block.generation = serialNumberGeneration;
+	}
+	return block.next++;
+}
+
+const size_t Candidate::maxPoolSize;
+
+namespace {
+// Per-thread free list of candidates. The next pointer is stored in the freed
+// memory itself. The candidates left in the pool are released when the thread
+// exits.
+struct CandidatePool {
+	void *head;
+	size_t size;
+
+	~CandidatePool() {
+		while (head) {
+			void *p = head;
+			head = *static_cast<void **>(p);
+			::operator delete(p);
+		}
+		// candidates deleted later during the thread exit bypass the pool
+		size = Candidate::maxPoolSize;
+	}
+};
+thread_local CandidatePool candidatePool = {0, 0};
+} // namespace
+
+void *Candidate::operator new(size_t size) {
+	CandidatePool &pool = candidatePool;
+	if ((size == sizeof(Candidate)) && pool.head) {
+		void *p = pool.head;
+		pool.head = *static_cast<void **>(p);
+		pool.size--;
+		return p;
+	}
+	return ::operator new(size);
+}
+
+void Candidate::operator delete(void *p, size_t size) {
+	if (p == 0)
+		return;
+	CandidatePool &pool = candidatePool;
+	if ((size == sizeof(Candidate)) && (pool.size < maxPoolSize)) {
+		*static_cast<void **>(p) = pool.head;
+		pool.head = p;
+		pool.size++;
+		return;
+	}
+	::operator delete(p);
+}
 
 void Candidate::restart() {
 	setActive(true);
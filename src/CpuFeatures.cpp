@@ -0,0 +1,69 @@
+#include "crpropa/CpuFeatures.h"
+
+#include <algorithm>
+
+namespace crpropa {
+
+static SimdLevel detectSimdLevel() {
+#ifdef CRPROPA_HAVE_TARGET_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return SIMD_AVX2_FMA;
+	if (__builtin_cpu_supports("avx"))
+		return SIMD_AVX;
+	if (__builtin_cpu_supports("sse4.2"))
+		return SIMD_SSE42;
+	return SIMD_NONE;
+#else
+	// no runtime detection: use what the compiler was told to use
+#if defined(__AVX512F__)
+	return SIMD_AVX512;
+#elif defined(__AVX2__) && defined(__FMA__)
+	return SIMD_AVX2_FMA;
+#elif defined(__AVX__)
+	return SIMD_AVX;
+#elif defined(__SSE4_2__)
+	return SIMD_SSE42;
+#else
+	return SIMD_NONE;
+#endif
+#endif
+}
+
+static SimdLevel maximumSimdLevel = SIMD_AVX512;
+
+SimdLevel cpuSimdLevel() {
+	static const SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+void setMaximumSimdLevel(SimdLevel level) {
+	maximumSimdLevel = level;
+}
+
+SimdLevel getMaximumSimdLevel() {
+	return maximumSimdLevel;
+}
+
+SimdLevel getSimdLevel() {
+	return std::min(cpuSimdLevel(), maximumSimdLevel);
+}
+
+const char *simdLevelName(SimdLevel level) {
+	switch (level) {
+	case SIMD_SSE42:
+		return "SSE4.2";
+	case SIMD_AVX:
+		return "AVX";
+	case SIMD_AVX2_FMA:
+		return "AVX2+FMA";
+	case SIMD_AVX512:
+		return "AVX-512";
+	default:
+		return "none";
+	}
+}
+
+} // namespace crpropa
@@ -0,0 +1,251 @@
+#include "crpropa/DataTable.h"
+
+#include "kiss/logger.h"
+#include "kiss/string.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CRPROPA_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace crpropa {
+
+const uint32_t DataTable::binaryVersion;
+
+struct DataTableHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t rows;
+	uint64_t values;
+};
+
+static const char dataTableMagic[8] = "CRPTAB";
+
+typedef std::map<std::string, ref_ptr<DataTable> > DataTableCache;
+
+static DataTableCache &dataTableCache() {
+	static DataTableCache cache;
+	return cache;
+}
+
+DataTable::DataTable() : values(0), offsets(0), nRows(0), mapping(0), mappingSize(0) {
+}
+
+DataTable::~DataTable() {
+#ifdef CRPROPA_HAVE_MMAP
+	if (mapping)
+		munmap(mapping, mappingSize);
+#endif
+}
+
+ref_ptr<DataTable> DataTable::load(const std::string &filename) {
+	ref_ptr<DataTable> table;
+#pragma omp critical(DataTable)
+	{
+		DataTableCache::iterator it = dataTableCache().find(filename);
+		if (it != dataTableCache().end())
+			table = it->second;
+	}
+	if (table.valid())
+		return table;
+
+	table = new DataTable();
+	if (not table->mapBinary(binaryFilename(filename))) {
+		table->readText(filename);
+		return table;
+	}
+
+#pragma omp critical(DataTable)
+	{
+		// another thread might have loaded the same table in the meantime
+		DataTableCache::iterator it = dataTableCache().find(filename);
+		if (it != dataTableCache().end())
+			table = it->second;
+		else
+			dataTableCache()[filename] = table;
+	}
+	return table;
+}
+
+void DataTable::clearCache() {
+#pragma omp critical(DataTable)
+	dataTableCache().clear();
+}
+
+std::string DataTable::binaryFilename(const std::string &filename) {
+	if (kiss::ends_with(filename, ".txt"))
+		return filename.substr(0, filename.size() - 4) + ".bin";
+	return filename + ".bin";
+}
+
+void DataTable::readText(const std::string &filename) {
+	std::ifstream infile(filename.c_str(), std::ios::binary);
+	if (not infile.good())
+		throw std::runtime_error("crpropa::DataTable: could not open file " + filename);
+
+	// read the whole file at once and parse it in memory
+	std::stringstream ss;
+	ss << infile.rdbuf();
+	const std::string content = ss.str();
+
+	this->filename = filename;
+	ownOffsets.push_back(0);
+	const char *p = content.c_str();
+	const char *end = p + content.size();
+	size_t line = 0;
+	while (p < end) {
+		line++;
+		const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+		if (eol == 0)
+			eol = end;
+
+		if (*p != '#') {
+			size_t n = ownValues.size();
+			const char *q = p;
+			while (q < eol) {
+				char *next;
+				double value = std::strtod(q, &next);
+				if (next == q || next > eol)
+					break;
+				ownValues.push_back(value);
+				q = next;
+			}
+			// skip lines without values
+			if (ownValues.size() > n) {
+				ownOffsets.push_back(ownValues.size());
+				ownLines.push_back(line);
+			}
+		}
+		p = eol + 1;
+	}
+
+	nRows = ownOffsets.size() - 1;
+	offsets = &ownOffsets[0];
+	values = ownValues.empty() ? 0 : &ownValues[0];
+}
+
+bool DataTable::mapBinary(const std::string &filename) {
+#ifdef CRPROPA_HAVE_MMAP
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || (st.st_size < (off_t) sizeof(DataTableHeader))) {
+		close(fd);
+		return false;
+	}
+
+	void *m = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (m == MAP_FAILED)
+		return false;
+
+	const DataTableHeader *header = static_cast<const DataTableHeader *>(m);
+	const uint64_t *fileOffsets = reinterpret_cast<const uint64_t *>(static_cast<const char *>(m) + sizeof(DataTableHeader));
+	// bound the counts by the file size first, so that the size check cannot overflow
+	bool valid = (std::memcmp(header->magic, dataTableMagic, sizeof(dataTableMagic)) == 0)
+			&& (header->version == binaryVersion)
+			&& (header->rows < (uint64_t) st.st_size / sizeof(uint64_t))
+			&& (header->values <= (uint64_t) st.st_size / sizeof(double))
+			&& (sizeof(DataTableHeader) + (header->rows + 1) * sizeof(uint64_t)
+				+ header->values * sizeof(double) == (uint64_t) st.st_size);
+	// the offsets start at 0, never decrease and end at the number of values
+	if (valid)
+		valid = (fileOffsets[0] == 0) && (fileOffsets[header->rows] == header->values);
+	for (uint64_t i = 0; valid && (i < header->rows); i++)
+		valid = (fileOffsets[i] <= fileOffsets[i + 1]);
+	if (not valid) {
+		KISS_LOG_WARNING << "DataTable: ignoring invalid binary file " << filename;
+		munmap(m, st.st_size);
+		return false;
+	}
+
+	this->filename = filename;
+	mapping = m;
+	mappingSize = st.st_size;
+	nRows = header->rows;
+	offsets = fileOffsets;
+	values = reinterpret_cast<const double *>(offsets + nRows + 1);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void DataTable::saveBinary(const std::string &filename) const {
+	std::ofstream outfile(filename.c_str(), std::ios::binary);
+	if (not outfile.good())
+		throw std::runtime_error("crpropa::DataTable: could not open file " + filename);
+
+	DataTableHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, dataTableMagic, sizeof(dataTableMagic));
+	header.version = binaryVersion;
+	header.rows = nRows;
+	header.values = size();
+
+	outfile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	outfile.write(reinterpret_cast<const char *>(offsets), (nRows + 1) * sizeof(uint64_t));
+	outfile.write(reinterpret_cast<const char *>(values), size() * sizeof(double));
+	if (not outfile.good())
+		throw std::runtime_error("crpropa::DataTable: could not write file " + filename);
+}
+
+size_t DataTable::rows() const {
+	return nRows;
+}
+
+size_t DataTable::rowSize(size_t row) const {
+	return offsets[row + 1] - offsets[row];
+}
+
+const double *DataTable::row(size_t row) const {
+	return values + offsets[row];
+}
+
+const double *DataTable::row(size_t row, size_t minSize) const {
+	if (rowSize(row) < minSize) {
+		// binary files have no line numbers, report the row instead
+		std::stringstream ss;
+		ss << "crpropa::DataTable: " << filename;
+		if (ownLines.empty())
+			ss << " row " << row + 1;
+		else
+			ss << " line " << ownLines[row];
+		ss << ": expected " << minSize << " values, found " << rowSize(row);
+		throw std::runtime_error(ss.str());
+	}
+	return values + offsets[row];
+}
+
+size_t DataTable::size() const {
+	return offsets[nRows];
+}
+
+const double *DataTable::data() const {
+	return values;
+}
+
+double DataTable::get(size_t row, size_t column) const {
+	if ((row >= nRows) || (column >= rowSize(row)))
+		throw std::out_of_range("crpropa::DataTable: index out of range");
+	return values[offsets[row] + column];
+}
+
+bool DataTable::isMapped() const {
+	return mapping != 0;
+}
+
+} // namespace crpropa
@@ -1,8 +1,20 @@
 #include "crpropa/GridTools.h"
 #include "crpropa/magneticField/MagneticField.h"
+#include "crpropa/ProgressBar.h"
 
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CRPROPA_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace crpropa {
 
@@ -10,14 +22,14 @@ void scaleGrid(ref_ptr<Grid1f> grid, double a) {
 	for (int ix = 0; ix < grid->getNx(); ix++)
 		for (int iy = 0; iy < grid->getNy(); iy++)
 			for (int iz = 0; iz < grid->getNz(); iz++)
-				grid->get(ix, iy, iz) *= a;
+				grid->setValue(ix, iy, iz, grid->getValue(ix, iy, iz) * a);
 }
 
 void scaleGrid(ref_ptr<Grid3f> grid, double a) {
 	for (int ix = 0; ix < grid->getNx(); ix++)
 		for (int iy = 0; iy < grid->getNy(); iy++)
 			for (int iz = 0; iz < grid->getNz(); iz++)
-				grid->get(ix, iy, iz) *= a;
+				grid->setValue(ix, iy, iz, grid->getValue(ix, iy, iz) * a);
 }
 
 Vector3f meanFieldVector(ref_ptr<Grid3f> grid) {
@@ -28,7 +40,7 @@ Vector3f meanFieldVector(ref_ptr<Grid3f> grid) {
 	for (int ix = 0; ix < Nx; ix++)
 		for (int iy = 0; iy < Ny; iy++)
 			for (int iz = 0; iz < Nz; iz++)
-				mean += grid->get(ix, iy, iz);
+				mean += grid->getValue(ix, iy, iz);
 	return mean / Nx / Ny / Nz;
 }
 
@@ -40,7 +52,7 @@ double meanFieldStrength(ref_ptr<Grid3f> grid) {
 	for (int ix = 0; ix < Nx; ix++)
 		for (int iy = 0; iy < Ny; iy++)
 			for (int iz = 0; iz < Nz; iz++)
-				mean += grid->get(ix, iy, iz).getR();
+				mean += grid->getValue(ix, iy, iz).getR();
 	return mean / Nx / Ny / Nz;
 }
 
@@ -52,7 +64,7 @@ double meanFieldStrength(ref_ptr<Grid1f> grid) {
 	for (int ix = 0; ix < Nx; ix++)
 		for (int iy = 0; iy < Ny; iy++)
 			for (int iz = 0; iz < Nz; iz++)
-				mean += grid->get(ix, iy, iz);
+				mean += grid->getValue(ix, iy, iz);
 	return mean / Nx / Ny / Nz;
 }
 
@@ -64,7 +76,7 @@ double rmsFieldStrength(ref_ptr<Grid3f> grid) {
 	for (int ix = 0; ix < Nx; ix++)
 		for (int iy = 0; iy < Ny; iy++)
 			for (int iz = 0; iz < Nz; iz++)
-				sumV2 += grid->get(ix, iy, iz).getR2();
+				sumV2 += grid->getValue(ix, iy, iz).getR2();
 	return std::sqrt(sumV2 / Nx / Ny / Nz);
 }
 
@@ -76,7 +88,7 @@ double rmsFieldStrength(ref_ptr<Grid1f> grid) {
 	for (int ix = 0; ix < Nx; ix++)
 		for (int iy = 0; iy < Ny; iy++)
 			for (int iz = 0; iz < Nz; iz++)
-				sumV2 += pow(grid->get(ix, iy, iz), 2);
+				sumV2 += pow(grid->getValue(ix, iy, iz), 2);
 	return std::sqrt(sumV2 / Nx / Ny / Nz);
 }
 
@@ -90,9 +102,9 @@ std::array<float, 3> rmsFieldStrengthPerAxis(ref_ptr<Grid3f> grid) {
     for (int ix = 0; ix < Nx; ix++)
         for (int iy = 0; iy < Ny; iy++)
             for (int iz = 0; iz < Nz; iz++) {
-                sumV2_x += pow(grid->get(ix, iy, iz).x, 2);
-                sumV2_y += pow(grid->get(ix, iy, iz).y, 2);
-                sumV2_z += pow(grid->get(ix, iy, iz).z, 2);
+                sumV2_x += pow(grid->getValue(ix, iy, iz).x, 2);
+                sumV2_y += pow(grid->getValue(ix, iy, iz).y, 2);
+                sumV2_z += pow(grid->getValue(ix, iy, iz).z, 2);
             }
     return {
         std::sqrt(sumV2_x / Nx / Ny / Nz),
@@ -101,34 +113,68 @@ std::array<float, 3> rmsFieldStrengthPerAxis(ref_ptr<Grid3f> grid) {
     };
 }
 
-void fromMagneticField(ref_ptr<Grid3f> grid, ref_ptr<MagneticField> field) {
-	Vector3d origin = grid->getOrigin();
-	Vector3d spacing = grid->getSpacing();
-	size_t Nx = grid->getNx();
-	size_t Ny = grid->getNy();
-	size_t Nz = grid->getNz();
-	for (size_t ix = 0; ix < Nx; ix++)
-		for (size_t iy = 0; iy < Ny; iy++)
-			for (size_t iz = 0; iz < Nz; iz++) {
-				Vector3d pos = Vector3d(double(ix) + 0.5, double(iy) + 0.5, double(iz) + 0.5) * spacing + origin;
-				Vector3d B = field->getField(pos);
-				grid->get(ix, iy, iz) = B;
-	}
+static inline void storeField(Vector3f &value, const Vector3d &B) {
+	value = B;
 }
 
-void fromMagneticFieldStrength(ref_ptr<Grid1f> grid, ref_ptr<MagneticField> field) {
-	Vector3d origin = grid->getOrigin();
-	Vector3d spacing = grid->getSpacing();
-	size_t Nx = grid->getNx();
-	size_t Ny = grid->getNy();
-	size_t Nz = grid->getNz();
-	for (size_t ix = 0; ix < Nx; ix++)
-		for (size_t iy = 0; iy < Ny; iy++)
-			for (size_t iz = 0; iz < Nz; iz++) {
-				Vector3d pos = Vector3d(double(ix) + 0.5, double(iy) + 0.5, double(iz) + 0.5) * spacing + origin;
-				double s = field->getField(pos).getR();
-				grid->get(ix, iy, iz) = s;
+static inline void storeField(float &value, const Vector3d &B) {
+	value = B.getR();
+}
+
+// Evaluate the field at the cell centers, one row along z per call of
+// getFields. The rows are distributed over the OpenMP threads.
+template<typename T>
+static void sampleMagneticField(ref_ptr<Grid<T> > grid, ref_ptr<MagneticField> field, bool showProgress, const std::string &title) {
+	Grid<T> *g = grid;
+	const MagneticField *f = field;
+	Vector3d origin = g->getOrigin();
+	Vector3d spacing = g->getSpacing();
+	size_t Nx = g->getNx();
+	size_t Ny = g->getNy();
+	size_t Nz = g->getNz();
+	long nRows = Nx * Ny;
+
+	ProgressBar progressbar(nRows);
+	if (showProgress)
+		progressbar.start(title);
+
+	std::string error;
+#pragma omp parallel
+	{
+		std::vector<Vector3d> pos(Nz), B(Nz);
+#pragma omp for schedule(dynamic)
+		for (long row = 0; row < nRows; row++) {
+			size_t ix = row / Ny;
+			size_t iy = row % Ny;
+			try {
+				for (size_t iz = 0; iz < Nz; iz++)
+					pos[iz] = Vector3d(double(ix) + 0.5, double(iy) + 0.5, double(iz) + 0.5) * spacing + origin;
+				f->getFields(&pos[0], &B[0], Nz);
+				for (size_t iz = 0; iz < Nz; iz++)
+					storeField(g->get(ix, iy, iz), B[iz]);
+			} catch (std::exception &e) {
+#pragma omp critical(sampleMagneticField)
+				error = e.what();
+			}
+			if (showProgress)
+#pragma omp critical(progressbarUpdate)
+				progressbar.update();
+		}
 	}
+
+	if (not error.empty()) {
+		if (showProgress)
+			progressbar.setError();
+		throw std::runtime_error(title + ": " + error);
+	}
+}
+
+void fromMagneticField(ref_ptr<Grid3f> grid, ref_ptr<MagneticField> field, bool showProgress) {
+	sampleMagneticField(grid, field, showProgress, "fromMagneticField");
+}
+
+void fromMagneticFieldStrength(ref_ptr<Grid1f> grid, ref_ptr<MagneticField> field, bool showProgress) {
+	sampleMagneticField(grid, field, showProgress, "fromMagneticFieldStrength");
 }
 
 void loadGrid(ref_ptr<Grid3f> grid, std::string filename, double c) {
@@ -154,11 +200,11 @@ void loadGrid(ref_ptr<Grid3f> grid, std::string filename, double c) {
 	for (int ix = 0; ix < grid->getNx(); ix++) {
 		for (int iy = 0; iy < grid->getNy(); iy++) {
 			for (int iz = 0; iz < grid->getNz(); iz++) {
-				Vector3f &b = grid->get(ix, iy, iz);
+				Vector3f b;
 				fin.read((char*) &(b.x), sizeof(float));
 				fin.read((char*) &(b.y), sizeof(float));
 				fin.read((char*) &(b.z), sizeof(float));
-				b *= c;
+				grid->setValue(ix, iy, iz, b * c);
 			}
 		}
 	}
@@ -188,9 +234,9 @@ void loadGrid(ref_ptr<Grid1f> grid, std::string filename, double c) {
 	for (int ix = 0; ix < nx; ix++) {
 		for (int iy = 0; iy < ny; iy++) {
 			for (int iz = 0; iz < nz; iz++) {
-				float &b = grid->get(ix, iy, iz);
+				float b;
 				fin.read((char*) &b, sizeof(float));
-				b *= c;
+				grid->setValue(ix, iy, iz, b * c);
 			}
 		}
 	}
@@ -207,7 +253,7 @@ void dumpGrid(ref_ptr<Grid3f> grid, std::string filename, double c) {
 	for (int ix = 0; ix < grid->getNx(); ix++) {
 		for (int iy = 0; iy < grid->getNy(); iy++) {
 			for (int iz = 0; iz < grid->getNz(); iz++) {
-				Vector3f b = grid->get(ix, iy, iz) * c;
+				Vector3f b = grid->getValue(ix, iy, iz) * c;
 				fout.write((char*) &(b.x), sizeof(float));
 				fout.write((char*) &(b.y), sizeof(float));
 				fout.write((char*) &(b.z), sizeof(float));
@@ -227,7 +273,7 @@ void dumpGrid(ref_ptr<Grid1f> grid, std::string filename, double c) {
 	for (int ix = 0; ix < grid->getNx(); ix++) {
 		for (int iy = 0; iy < grid->getNy(); iy++) {
 			for (int iz = 0; iz < grid->getNz(); iz++) {
-				float b = grid->get(ix, iy, iz) * c;
+				float b = grid->getValue(ix, iy, iz) * c;
 				fout.write((char*) &b, sizeof(float));
 			}
 		}
@@ -249,11 +295,11 @@ void loadGridFromTxt(ref_ptr<Grid3f> grid, std::string filename, double c) {
 	for (int ix = 0; ix < grid->getNx(); ix++) {
 		for (int iy = 0; iy < grid->getNy(); iy++) {
 			for (int iz = 0; iz < grid->getNz(); iz++) {
-				Vector3f &b = grid->get(ix, iy, iz);
+				Vector3f b;
 				fin >> b.x >> b.y >> b.z;
-				b *= c;
 				if (fin.eof())
 					throw std::runtime_error("load Grid3f: file too short");
+				grid->setValue(ix, iy, iz, b * c);
 			}
 		}
 	}
@@ -343,11 +389,11 @@ void loadGridFromTxt(ref_ptr<Grid1f> grid, std::string filename, double c) {
 	for (int ix = 0; ix < grid->getNx(); ix++) {
 		for (int iy = 0; iy < grid->getNy(); iy++) {
 			for (int iz = 0; iz < grid->getNz(); iz++) {
-				float &b = grid->get(ix, iy, iz);
+				float b;
 				fin >> b;
-				b *= c;
 				if (fin.eof())
 					throw std::runtime_error("load Grid1f: file too short");
+				grid->setValue(ix, iy, iz, b * c);
 			}
 		}
 	}
@@ -443,7 +489,7 @@ void dumpGridToTxt(ref_ptr<Grid3f> grid, std::string filename, double c, bool sa
 	for (int ix = 0; ix < grid->getNx(); ix++) {
 		for (int iy = 0; iy < grid->getNy(); iy++) {
 			for (int iz = 0; iz < grid->getNz(); iz++) {
-				Vector3f b = grid->get(ix, iy, iz) * c;
+				Vector3f b = grid->getValue(ix, iy, iz) * c;
 				fout << b << "\n";
 			}
 		}
@@ -473,7 +519,7 @@ void dumpGridToTxt(ref_ptr<Grid1f> grid, std::string filename, double c, bool sa
 	for (int ix = 0; ix < grid->getNx(); ix++) {
 		for (int iy = 0; iy < grid->getNy(); iy++) {
 			for (int iz = 0; iz < grid->getNz(); iz++) {
-				float b = grid->get(ix, iy, iz) * c;
+				float b = grid->getValue(ix, iy, iz) * c;
 				fout << b << "\n";
 			}
 		}
@@ -481,6 +527,159 @@ void dumpGridToTxt(ref_ptr<Grid1f> grid, std::string filename, double c, bool sa
 	fout.close();
 }
 
+struct GridFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t components; // 1: Grid1f, 3: Grid3f
+	uint64_t Nx, Ny, Nz;
+	double origin[3];
+	double spacing[3];
+	uint32_t reflective;
+	uint32_t clipVolume;
+	uint32_t ipol;
+	char reserved[28];
+};
+
+static const char gridFileMagic[8] = "CRPGRID";
+static const uint32_t gridFileVersion = 1;
+
+GridMapping::GridMapping(const std::string &filename) :
+		filename(filename), address(0), length(0), mapped(false) {
+#ifdef CRPROPA_HAVE_MMAP
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("GridMapping: could not open file " + filename);
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw std::runtime_error("GridMapping: could not stat file " + filename);
+	}
+	length = st.st_size;
+	void *m = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (m == MAP_FAILED)
+		throw std::runtime_error("GridMapping: could not map file " + filename);
+	address = static_cast<char *>(m);
+	mapped = true;
+#else
+	// no memory mapping available: read the file into memory
+	std::ifstream fin(filename.c_str(), std::ios::binary);
+	if (!fin)
+		throw std::runtime_error("GridMapping: could not open file " + filename);
+	fin.seekg(0, fin.end);
+	length = fin.tellg();
+	fin.seekg(0, fin.beg);
+	address = static_cast<char *>(std::malloc(length));
+	if (address == 0)
+		throw std::runtime_error("GridMapping: could not allocate memory for " + filename);
+	fin.read(address, length);
+#endif
+}
+
+GridMapping::~GridMapping() {
+#ifdef CRPROPA_HAVE_MMAP
+	if (mapped)
+		munmap(address, length);
+#endif
+	if (!mapped)
+		std::free(address);
+}
+
+const std::string &GridMapping::getFilename() const {
+	return filename;
+}
+
+const char *GridMapping::data() const {
+	return address;
+}
+
+size_t GridMapping::size() const {
+	return length;
+}
+
+template<typename T>
+static void dumpGridBinaryImpl(ref_ptr<Grid<T> > grid, std::string filename, uint32_t components, double c) {
+	std::ofstream fout(filename.c_str(), std::ios::binary);
+	if (!fout) {
+		std::stringstream ss;
+		ss << "dumpGridBinary: " << filename << " not found";
+		throw std::runtime_error(ss.str());
+	}
+
+	GridFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, gridFileMagic, sizeof(gridFileMagic));
+	header.version = gridFileVersion;
+	header.components = components;
+	header.Nx = grid->getNx();
+	header.Ny = grid->getNy();
+	header.Nz = grid->getNz();
+	Vector3d origin = grid->getOrigin();
+	Vector3d spacing = grid->getSpacing();
+	for (int i = 0; i < 3; i++) {
+		header.origin[i] = origin.data[i];
+		header.spacing[i] = spacing.data[i];
+	}
+	header.reflective = grid->isReflective();
+	header.clipVolume = grid->getClipVolume();
+	header.ipol = grid->getInterpolationType();
+	fout.write((char*) &header, sizeof(header));
+
+	for (size_t ix = 0; ix < grid->getNx(); ix++) {
+		for (size_t iy = 0; iy < grid->getNy(); iy++) {
+			for (size_t iz = 0; iz < grid->getNz(); iz++) {
+				T b = grid->getValue(ix, iy, iz) * c;
+				fout.write((char*) &b, sizeof(T));
+			}
+		}
+	}
+	if (!fout)
+		throw std::runtime_error("dumpGridBinary: could not write file " + filename);
+}
+
+template<typename T>
+static ref_ptr<Grid<T> > mapGridImpl(std::string filename, uint32_t components) {
+	ref_ptr<GridMapping> mapping = new GridMapping(filename);
+	if (mapping->size() < sizeof(GridFileHeader))
+		throw std::runtime_error("mapGrid: " + filename + " is not a grid file");
+
+	GridFileHeader header;
+	std::memcpy(&header, mapping->data(), sizeof(header));
+	if (std::memcmp(header.magic, gridFileMagic, sizeof(gridFileMagic)) != 0)
+		throw std::runtime_error("mapGrid: " + filename + " is not a grid file");
+	if (header.version != gridFileVersion)
+		throw std::runtime_error("mapGrid: unsupported version of grid file " + filename);
+	if (header.components != components) {
+		std::stringstream ss;
+		ss << "mapGrid: " << filename << " holds " << header.components << " components per grid point, expected " << components;
+		throw std::runtime_error(ss.str());
+	}
+
+	GridProperties gp(Vector3d(header.origin[0], header.origin[1], header.origin[2]),
+			header.Nx, header.Ny, header.Nz,
+			Vector3d(header.spacing[0], header.spacing[1], header.spacing[2]));
+	gp.setReflective(header.reflective);
+	gp.setClipVolume(header.clipVolume);
+	gp.setInterpolationType((interpolationType) header.ipol);
+	return new Grid<T>(gp, mapping, sizeof(GridFileHeader));
+}
+
+void dumpGridBinary(ref_ptr<Grid3f> grid, std::string filename, double c) {
+	dumpGridBinaryImpl<Vector3f>(grid, filename, 3, c);
+}
+
+void dumpGridBinary(ref_ptr<Grid1f> grid, std::string filename, double c) {
+	dumpGridBinaryImpl<float>(grid, filename, 1, c);
+}
+
+ref_ptr<Grid3f> mapGrid3f(std::string filename) {
+	return mapGridImpl<Vector3f>(filename, 3);
+}
+
+ref_ptr<Grid1f> mapGrid1f(std::string filename) {
+	return mapGridImpl<float>(filename, 1);
+}
+
 #ifdef CRPROPA_HAVE_FFTW3F
 
 std::vector<std::pair<int, float>> gridPowerSpectrum(ref_ptr<Grid3f> grid) {
@@ -504,7 +703,7 @@ std::vector<std::pair<int, float>> gridPowerSpectrum(ref_ptr<Grid3f> grid) {
     for (size_t iy = 0; iy < n; iy++) {
       for (size_t iz = 0; iz < n; iz++) {
         i = ix * n * n + iy * n + iz;
-        Vector3<float> &b = grid->get(ix, iy, iz);
+        Vector3<float> b = grid->getValue(ix, iy, iz);
         Bx[i][0] = b.x / rms;
         By[i][0] = b.y / rms;
         Bz[i][0] = b.z / rms;
@@ -65,6 +65,10 @@
 
 namespace crpropa {
 
+// seed of the counter-based random streams
+static bool g_haveStreams = false;
+static uint64_t g_streamSeed = 0;
+
 Random::Random(const uint32_t& oneSeed) {
 	seed(oneSeed);
 }
@@ -138,6 +142,10 @@ size_t Random::randBin(const std::vector<double> &cdf) {
 	return it - cdf.begin();
 }
 
+size_t Random::randBin(const double *cdf, size_t n) {
+	return std::lower_bound(cdf, cdf + n, rand() * cdf[n - 1]) - cdf;
+}
+
 Vector3d Random::randVector() {
 	double z = randUniform(-1.0, 1.0);
 	double t = randUniform(-1.0 * M_PI, M_PI);
@@ -247,6 +255,12 @@ double Random::randExponential() {
 }
 
 uint32_t Random::randInt() {
+	if (streamMode) {
+		if (streamLeft == 0)
+			reloadStream();
+		return streamBuffer[4 - streamLeft--];
+	}
+
 	if (left == 0)
 		reload();
 	--left;
@@ -378,6 +392,9 @@ void Random::seed() {
 
 
 void Random::initialize(const uint32_t seed) {
+	streamMode = false;
+	streamLeft = 0;
+
 	uint32_t *s = state;
 	uint32_t *r = state;
 	int i = 1;
@@ -400,6 +417,52 @@ void Random::reload() {
 	left = N, pNext = state;
 }
 
+void Random::setStream(uint64_t stream, uint32_t step) {
+	uint64_t key = g_streamSeed;
+	streamKey[0] = (uint32_t) key;
+	streamKey[1] = (uint32_t) (key >> 32);
+	streamCounter[0] = 0;
+	streamCounter[1] = step;
+	streamCounter[2] = (uint32_t) stream;
+	streamCounter[3] = (uint32_t) (stream >> 32);
+	streamLeft = 0;
+	streamMode = true;
+}
+
+uint64_t Random::deriveStream(uint64_t stream, uint64_t index) {
+	// splitmix64 finalizer
+	uint64_t z = stream ^ ((index + 1) * 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Philox4x32-10, see J. K. Salmon et al., "Parallel random numbers: as easy
+// as 1, 2, 3", SC '11 (2011), doi:10.1145/2063384.2063405
+void Random::reloadStream() {
+	uint32_t c0 = streamCounter[0], c1 = streamCounter[1];
+	uint32_t c2 = streamCounter[2], c3 = streamCounter[3];
+	uint32_t k0 = streamKey[0], k1 = streamKey[1];
+	for (int round = 0; round < 10; round++) {
+		if (round > 0) {
+			k0 += 0x9E3779B9UL;
+			k1 += 0xBB67AE85UL;
+		}
+		uint64_t p0 = uint64_t(0xD2511F53UL) * c0;
+		uint64_t p1 = uint64_t(0xCD9E8D57UL) * c2;
+		c0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+		c1 = uint32_t(p1);
+		c2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+		c3 = uint32_t(p0);
+	}
+	streamBuffer[0] = c0;
+	streamBuffer[1] = c1;
+	streamBuffer[2] = c2;
+	streamBuffer[3] = c3;
+	streamLeft = 4;
+	streamCounter[0]++;
+}
+
 uint32_t Random::hash(time_t t, clock_t c) {
 	static uint32_t differ = 0; // guarantee time-based seeds will change
 
@@ -460,6 +523,15 @@ std::istream& operator>>(std::istream& is, Random& mtrand) {
 	return is;
 }
 
+bool Random::haveStreams() {
+	return g_haveStreams;
+}
+
+void Random::enableStreams(uint64_t seed) {
+	g_streamSeed = seed;
+	g_haveStreams = true;
+}
+
 #ifdef _OPENMP
 #include <omp.h>
 #include <stdexcept>
@@ -490,6 +562,12 @@ void Random::seedThreads(const uint32_t oneSeed) {
 	_tls[i].r.seed(oneSeed + i);
 }
 
+void Random::disableStreams() {
+	g_haveStreams = false;
+	for(size_t i = 0; i < MAX_THREAD; ++i)
+	_tls[i].r.streamMode = false;
+}
+
 std::vector< std::vector<uint32_t> > Random::getSeedThreads()
 {
 	std::vector< std::vector<uint32_t> > seeds;
@@ -506,6 +584,10 @@ Random &Random::instance() {
 void Random::seedThreads(const uint32_t oneSeed) {
 	_random.seed(oneSeed);
 }
+void Random::disableStreams() {
+	g_haveStreams = false;
+	_random.streamMode = false;
+}
 std::vector< std::vector<uint32_t> > Random::getSeedThreads()
 {
 	std::vector< std::vector<uint32_t> > seeds;
@@ -668,12 +668,13 @@ void SourceUniform1D::setDescription() {
 // ----------------------------------------------------------------------------
 SourceDensityGrid::SourceDensityGrid(ref_ptr<Grid1f> grid) :
 		grid(grid) {
-	float sum = 0;
+	cdf.reserve(grid->getNx() * grid->getNy() * grid->getNz());
+	double sum = 0;
 	for (int ix = 0; ix < grid->getNx(); ix++) {
 		for (int iy = 0; iy < grid->getNy(); iy++) {
 			for (int iz = 0; iz < grid->getNz(); iz++) {
-				sum += grid->get(ix, iy, iz);
-				grid->get(ix, iy, iz) = sum;
+				sum += grid->getValue(ix, iy, iz);
+				cdf.push_back(sum);
 			}
 		}
 	}
@@ -684,7 +685,7 @@ void SourceDensityGrid::prepareParticle(ParticleState& particle) const {
 	Random &random = Random::instance();
 
 	// draw random bin
-	size_t i = random.randBin(grid->getGrid());
+	size_t i = random.randBin(cdf);
 	Vector3d pos = grid->positionFromIndex(i);
 
 	// draw uniform position within bin
@@ -708,10 +709,11 @@ SourceDensityGrid1D::SourceDensityGrid1D(ref_ptr<Grid1f> grid) :
 	if (grid->getNz() != 1)
 		throw std::runtime_error("SourceDensityGrid1D: Nz != 1");
 
-	float sum = 0;
+	cdf.reserve(grid->getNx());
+	double sum = 0;
 	for (int ix = 0; ix < grid->getNx(); ix++) {
-		sum += grid->get(ix, 0, 0);
-		grid->get(ix, 0, 0) = sum;
+		sum += grid->getValue(ix, 0, 0);
+		cdf.push_back(sum);
 	}
 	setDescription();
 }
@@ -720,7 +722,7 @@ void SourceDensityGrid1D::prepareParticle(ParticleState& particle) const {
 	Random &random = Random::instance();
 
 	// draw random bin
-	size_t i = random.randBin(grid->getGrid());
+	size_t i = random.randBin(cdf);
 	Vector3d pos = grid->positionFromIndex(i);
 
 	// draw uniform position within bin
@@ -1076,6 +1078,7 @@ void SourceMassDistribution::setXrange(double xMin, double xMax) {
 	}
 	this -> xMin = xMin;
 	this -> xMax = xMax;
+	updateSamplingGrid();
 }
 
 void SourceMassDistribution::setYrange(double yMin, double yMax) {
@@ -1085,6 +1088,7 @@ void SourceMassDistribution::setYrange(double yMin, double yMax) {
 	}
 	this -> yMin = yMin;
 	this -> yMax = yMax;
+	updateSamplingGrid();
 }
 
 void SourceMassDistribution::setZrange(double zMin, double zMax) {
@@ -1094,9 +1098,61 @@ void SourceMassDistribution::setZrange(double zMin, double zMax) {
 	}
 	this -> zMin = zMin;
 	this -> zMax = zMax;
+	updateSamplingGrid();
+}
+
+void SourceMassDistribution::setSamplingGrid(size_t nx, size_t ny, size_t nz, int subsamples) {
+	if (subsamples < 1)
+		throw std::runtime_error("SourceMassDistribution: number of subsamples must be positive");
+	this -> nx = nx;
+	this -> ny = ny;
+	this -> nz = nz;
+	this -> subsamples = subsamples;
+	updateSamplingGrid();
+}
+
+void SourceMassDistribution::updateSamplingGrid() {
+	if ((nx == 0) || (ny == 0) || (nz == 0)) {
+		samplingGrid = NULL;
+		return;
+	}
+
+	Vector3d origin(xMin, yMin, zMin);
+	Vector3d spacing((xMax - xMin) / nx, (yMax - yMin) / ny, (zMax - zMin) / nz);
+	ref_ptr<Grid1f> grid = new Grid1f(origin, nx, ny, nz, spacing);
+
+	// average the density over subsamples^3 points in each cell
+	double sum = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:sum)
+	for (int ix = 0; ix < (int)nx; ix++) {
+		for (size_t iy = 0; iy < ny; iy++) {
+			for (size_t iz = 0; iz < nz; iz++) {
+				double cellSum = 0;
+				for (int sx = 0; sx < subsamples; sx++)
+				for (int sy = 0; sy < subsamples; sy++)
+				for (int sz = 0; sz < subsamples; sz++) {
+					Vector3d pos = origin + Vector3d(ix + (sx + 0.5) / subsamples,
+							iy + (sy + 0.5) / subsamples, iz + (sz + 0.5) / subsamples) * spacing;
+					cellSum += density->getDensity(pos);
+				}
+				grid->get(ix, iy, iz) = cellSum / (subsamples * subsamples * subsamples);
+				sum += cellSum;
+			}
+		}
+	}
+	if (!(sum > 0))
+		throw std::runtime_error("SourceMassDistribution: density vanishes in the sampling range");
+
+	samplingGrid = new SourceDensityGrid(grid);
 }
 
 Vector3d SourceMassDistribution::samplePosition() const {
+	if (samplingGrid.valid()) {
+		ParticleState particle;
+		samplingGrid->prepareParticle(particle);
+		return particle.getPosition();
+	}
+
 	Vector3d pos; 
 	Random &rand = Random::instance();
 
@@ -1134,7 +1190,10 @@ std::string SourceMassDistribution::getDescription() {
 	ss << "\t x in [" << xMin / kpc << " ; " << xMax / kpc << "] kpc \n";
 	ss << "\t y in [" << yMin / kpc << " ; " << yMax / kpc << "] kpc \n";
 	ss << "\t z in [" << zMin / kpc << " ; " << zMax / kpc << "] kpc \n";
-	ss << "with maximal number of tries for sampling of " << maxTries << "\n";
+	if (samplingGrid.valid())
+		ss << "sampled from a grid of " << nx << " x " << ny << " x " << nz << " cells \n";
+	else
+		ss << "with maximal number of tries for sampling of " << maxTries << "\n";
 
 	return ss.str();
 }
@@ -0,0 +1,65 @@
+#include "crpropa/Symbol.h"
+
+#include <map>
+
+namespace crpropa {
+
+typedef std::map<std::string, const Symbol::Entry *> SymbolTable;
+
+static SymbolTable &symbolTable() {
+	static SymbolTable table;
+	return table;
+}
+
+// the empty symbol has index 0 and is not stored in the table
+static const Symbol::Entry *emptySymbol() {
+	static const Symbol::Entry entry = {std::string(), 0};
+	return &entry;
+}
+
+Symbol::Symbol() : entry(emptySymbol()) {
+}
+
+Symbol::Symbol(const std::string &name) : entry(intern(name)) {
+}
+
+Symbol::Symbol(const char *name) : entry(intern(name)) {
+}
+
+const Symbol::Entry *Symbol::intern(const std::string &name) {
+	if (name.empty())
+		return emptySymbol();
+
+	// each thread caches the names it has looked up, to avoid the lock
+	thread_local SymbolTable cache;
+	SymbolTable::const_iterator it = cache.find(name);
+	if (it != cache.end())
+		return it->second;
+
+	const Entry *e;
+#pragma omp critical(Symbol)
+	{
+		SymbolTable &table = symbolTable();
+		SymbolTable::const_iterator i = table.find(name);
+		if (i != table.end()) {
+			e = i->second;
+		} else {
+			Entry *n = new Entry;
+			n->name = name;
+			n->index = table.size() + 1;
+			table[name] = n;
+			e = n;
+		}
+	}
+	cache[name] = e;
+	return e;
+}
+
+size_t Symbol::count() {
+	size_t n;
+#pragma omp critical(Symbol)
+	n = symbolTable().size() + 1;
+	return n;
+}
+
+} // namespace crpropa
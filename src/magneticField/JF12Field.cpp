@@ -92,10 +92,8 @@ void JF12Field::randomStriated(int seed) {
 
 	for (int ix = 0; ix < N; ix++)
 		for (int iy = 0; iy < N; iy++)
-			for (int iz = 0; iz < N; iz++) {
-				float &f = striatedGrid->get(ix, iy, iz);
-				f = round(random.rand()) * 2 - 1;
-			}
+			for (int iz = 0; iz < N; iz++)
+				striatedGrid->setValue(ix, iy, iz, round(random.rand()) * 2 - 1);
 }
 
 #ifdef CRPROPA_HAVE_FFTW3F
@@ -351,6 +349,23 @@ Vector3d JF12Field::getField(const Vector3d& pos) const {
 	return b;
 }
 
+void JF12Field::getFields(const Vector3d *positions, Vector3d *fields,
+		size_t n, double z) const {
+	// the field components are switched once per batch
+	for (size_t i = 0; i < n; i++)
+		fields[i] = Vector3d(0.);
+	if (useTurbulentField)
+		for (size_t i = 0; i < n; i++)
+			fields[i] += getTurbulentField(positions[i]);
+	if (useStriatedField) {
+		for (size_t i = 0; i < n; i++)
+			fields[i] += getStriatedField(positions[i]);
+	} else if (useRegularField) {
+		for (size_t i = 0; i < n; i++)
+			fields[i] += getRegularField(positions[i]);
+	}
+}
+
 
 
 PlanckJF12bField::PlanckJF12bField() : JF12Field::JF12Field(){
@@ -176,6 +176,13 @@ Vector3d KST24Field::getField(const Vector3d& pos) const
 	return vals*gauss;
 }
 
+void KST24Field::getFields(const Vector3d *positions, Vector3d *fields,
+		size_t n, double z) const
+{
+	for (size_t i = 0; i < n; i++)
+		fields[i] = KST24Field::getField(positions[i]);
+}
+
 bool KST24Field::is_LB(const Vector3d pos_kpc, const double LB_rmin_kpc, const double LB_dr_kpc,
 					   const double LB_x0_kpc, const double LB_y0_kpc, const double LB_z0_kpc) const
 {
@@ -2,6 +2,20 @@
 
 namespace crpropa {
 
+void MagneticField::getFields(const Vector3d *positions, Vector3d *fields,
+		size_t n, double z) const {
+	for (size_t i = 0; i < n; i++)
+		fields[i] = getField(positions[i], z);
+}
+
+std::vector<Vector3d> MagneticField::getFields(
+		const std::vector<Vector3d> &positions, double z) const {
+	std::vector<Vector3d> fields(positions.size());
+	if (!positions.empty())
+		getFields(&positions[0], &fields[0], positions.size(), z);
+	return fields;
+}
+
 PeriodicMagneticField::PeriodicMagneticField(ref_ptr<MagneticField> field,
 		const Vector3d &extends) :
 		field(field), extends(extends), origin(0, 0, 0), reflective(false) {
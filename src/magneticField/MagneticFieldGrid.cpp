@@ -18,6 +18,13 @@ Vector3d MagneticFieldGrid::getField(const Vector3d &pos) const {
 	return grid->interpolate(pos);
 }
 
+void MagneticFieldGrid::getFields(const Vector3d *positions, Vector3d *fields,
+		size_t n, double z) const {
+	Grid3f *g = grid;
+	for (size_t i = 0; i < n; i++)
+		fields[i] = g->interpolate(positions[i]);
+}
+
 ModulatedMagneticFieldGrid::ModulatedMagneticFieldGrid(ref_ptr<Grid3f> grid,
 		ref_ptr<Grid1f> modGrid) {
 	grid->setReflective(false);
@@ -181,6 +181,12 @@ Vector3d TF17Field::getField(const Vector3d& pos) const {
 	return b;
 }
 
+void TF17Field::getFields(const Vector3d *positions, Vector3d *fields,
+		size_t n, double z) const {
+	for (size_t i = 0; i < n; i++)
+		fields[i] = TF17Field::getField(positions[i]);
+}
+
 Vector3d TF17Field::getDiskField(const double& r, const double& z, const double& phi, const double& sinPhi, const double& cosPhi) const {
 	Vector3d b(0.);
     double B_r = 0;
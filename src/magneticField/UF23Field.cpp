@@ -275,6 +275,15 @@ UF23Field::getField(const Vector3d &position)
   return (this->operator()(posInKpc)) / uf23::microgauss * microgauss;
 }
 
+void
+UF23Field::getFields(const Vector3d *positions, Vector3d *fields, size_t n,
+                     double z)
+  const
+{
+  for (size_t i = 0; i < n; i++)
+    fields[i] = (this->operator()(positions[i] / kpc)) / uf23::microgauss * microgauss;
+}
+
 
 Vector3d
 UF23Field::operator()(const Vector3d& posInKpc)
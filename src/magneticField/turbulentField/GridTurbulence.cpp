@@ -4,8 +4,87 @@
 
 #ifdef CRPROPA_HAVE_FFTW3F
 
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace crpropa {
 
+static int fftThreads = 0;
+static std::string fftWisdomFile;
+
+// Create an in-place, complex to real plan for a n^3 grid. The FFTW planner
+// is not thread safe, so planning is serialized. If the input already holds
+// data it must not be overwritten by measuring, hence only existing wisdom
+// is used for optimized plans then.
+static fftwf_plan planInverseFFT(size_t n, fftwf_complex *Bk, bool preserveInput) {
+	fftwf_plan plan = 0;
+#pragma omp critical(FFTW)
+	{
+#ifdef CRPROPA_HAVE_FFTW3F_THREADS
+		static bool threadsInitialized = false;
+		if (not threadsInitialized)
+			threadsInitialized = (fftwf_init_threads() != 0);
+		int nThreads = fftThreads;
+#ifdef _OPENMP
+		if (nThreads <= 0)
+			nThreads = omp_get_max_threads();
+#endif
+		fftwf_plan_with_nthreads(std::max(nThreads, 1));
+#endif
+		float *B = (float *)Bk;
+		if (fftWisdomFile.empty()) {
+			plan = fftwf_plan_dft_c2r_3d(n, n, n, Bk, B, FFTW_ESTIMATE);
+		} else {
+			fftwf_import_wisdom_from_filename(fftWisdomFile.c_str());
+			if (preserveInput)
+				plan = fftwf_plan_dft_c2r_3d(n, n, n, Bk, B, FFTW_MEASURE | FFTW_WISDOM_ONLY);
+			else
+				plan = fftwf_plan_dft_c2r_3d(n, n, n, Bk, B, FFTW_MEASURE);
+			if (plan == 0)
+				plan = fftwf_plan_dft_c2r_3d(n, n, n, Bk, B, FFTW_ESTIMATE);
+			else if (not preserveInput)
+				fftwf_export_wisdom_to_filename(fftWisdomFile.c_str());
+		}
+	}
+	if (plan == 0)
+		throw std::runtime_error("GridTurbulence: could not create FFTW plan");
+	return plan;
+}
+
+// Copy the result of an in-place transform (padded in z) to one component of the grid
+static void copyComponent(ref_ptr<Grid3f> grid, const float *B, int component) {
+	size_t n = grid->getNx();
+	size_t n2 = (size_t)floor(n / 2) + 1;
+#pragma omp parallel for
+	for (size_t ix = 0; ix < n; ix++) {
+		for (size_t iy = 0; iy < n; iy++) {
+			for (size_t iz = 0; iz < n; iz++) {
+				size_t i = ix * n * 2 * n2 + iy * 2 * n2 + iz;
+				grid->get(ix, iy, iz).data[component] = B[i];
+			}
+		}
+	}
+}
+
+void GridTurbulence::setFFTThreads(int nThreads) {
+	fftThreads = nThreads;
+}
+
+int GridTurbulence::getFFTThreads() {
+	return fftThreads;
+}
+
+void GridTurbulence::setFFTWisdomFile(const std::string &filename) {
+	fftWisdomFile = filename;
+}
+
+std::string GridTurbulence::getFFTWisdomFile() {
+	return fftWisdomFile;
+}
+
 
 GridTurbulence::GridTurbulence(const TurbulenceSpectrum &spectrum,
                                const GridProperties &gridProp,
@@ -33,15 +112,21 @@ void GridTurbulence::initTurbulence() {
 	size_t n2 = (size_t)floor(n / 2) +
 	            1; // size array in z-direction in configuration space
 
-	// arrays to hold the complex vector components of the B(k)-field
-	fftwf_complex *Bkx, *Bky, *Bkz;
-	Bkx = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * n * n * n2);
-	Bky = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * n * n * n2);
-	Bkz = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * n * n * n2);
-
-	Random random;
-	if (seed != 0)
-		random.seed(seed); // use given seed
+	// the components of the B(k)-field are transformed one after another in
+	// a single complex array, so that only one array is allocated besides
+	// the grid. The plan is created before filling the array and reused.
+	fftwf_complex *Bk;
+	Bk = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * n * n * n2);
+	if (Bk == 0)
+		throw std::runtime_error("GridTurbulence: could not allocate FFT buffer");
+	fftwf_plan plan = planInverseFFT(n, Bk, false);
+
+	// each component replays the same random sequence, so that a seed gives
+	// the same field as with three separate arrays. The sequence is drawn
+	// serially, only the FFT and the copy into the grid run in parallel.
+	uint32_t componentSeed = seed;
+	if (seed == 0)
+		componentSeed = Random().randInt();
 
 	// calculate the n possible discrete wave numbers
 	double K[n];
@@ -56,67 +141,65 @@ void GridTurbulence::initTurbulence() {
 
 	Vector3f n0(1, 1, 1); // arbitrary vector to construct orthogonal base
 
-	for (size_t ix = 0; ix < n; ix++) {
-		for (size_t iy = 0; iy < n; iy++) {
-			for (size_t iz = 0; iz < n2; iz++) {
-	
-				Vector3f ek, e1, e2;  // orthogonal base
-
-				size_t i = ix * n * n2 + iy * n2 + iz;
-				ek.setXYZ(K[ix], K[iy], K[iz]);
-				double k = ek.getR();
-
-				// wave outside of turbulent range -> B(k) = 0
-				if ((k < kMin) || (k > kMax)) {
-					Bkx[i][0] = 0;
-					Bkx[i][1] = 0;
-					Bky[i][0] = 0;
-					Bky[i][1] = 0;
-					Bkz[i][0] = 0;
-					Bkz[i][1] = 0;
-					continue;
-				}
-
-				// construct an orthogonal base ek, e1, e2
-				if (ek.isParallelTo(n0, float(1e-3))) {
-					// ek parallel to (1,1,1)
-					e1.setXYZ(-1., 1., 0);
-					e2.setXYZ(1., 1., -2.);
-				} else {
-					// ek not parallel to (1,1,1)
-					e1 = n0.cross(ek);
-					e2 = ek.cross(e1);
-				}
-				e1 /= e1.getR();
-				e2 /= e2.getR();
-
-				// random orientation perpendicular to k
-				double theta = 2 * M_PI * random.rand();
-				Vector3f b = e1 * std::cos(theta) + e2 * std::sin(theta); // real b-field vector
-
-				// normal distributed amplitude with mean = 0
-				b *= std::sqrt(spectrum.energySpectrum(k*lambda));
-				
-				// uniform random phase
-				double phase = 2 * M_PI * random.rand();
-				double cosPhase = std::cos(phase); // real part
-				double sinPhase = std::sin(phase); // imaginary part
-
-				Bkx[i][0] = b.x * cosPhase;
-				Bkx[i][1] = b.x * sinPhase;
-				Bky[i][0] = b.y * cosPhase;
-				Bky[i][1] = b.y * sinPhase;
-				Bkz[i][0] = b.z * cosPhase;
-				Bkz[i][1] = b.z * sinPhase;
-			} // for iz
-		}     // for iy
-	}         // for ix
-
-	executeInverseFFTInplace(gridPtr, Bkx, Bky, Bkz);
-
-	fftwf_free(Bkx);
-	fftwf_free(Bky);
-	fftwf_free(Bkz);
+	for (int component = 0; component < 3; component++) {
+		Random random;
+		random.seed(componentSeed);
+
+		for (size_t ix = 0; ix < n; ix++) {
+			for (size_t iy = 0; iy < n; iy++) {
+				for (size_t iz = 0; iz < n2; iz++) {
+
+					Vector3f ek, e1, e2;  // orthogonal base
+
+					size_t i = ix * n * n2 + iy * n2 + iz;
+					ek.setXYZ(K[ix], K[iy], K[iz]);
+					double k = ek.getR();
+
+					// wave outside of turbulent range -> B(k) = 0
+					if ((k < kMin) || (k > kMax)) {
+						Bk[i][0] = 0;
+						Bk[i][1] = 0;
+						continue;
+					}
+
+					// construct an orthogonal base ek, e1, e2
+					if (ek.isParallelTo(n0, float(1e-3))) {
+						// ek parallel to (1,1,1)
+						e1.setXYZ(-1., 1., 0);
+						e2.setXYZ(1., 1., -2.);
+					} else {
+						// ek not parallel to (1,1,1)
+						e1 = n0.cross(ek);
+						e2 = ek.cross(e1);
+					}
+					e1 /= e1.getR();
+					e2 /= e2.getR();
+
+					// random orientation perpendicular to k
+					double theta = 2 * M_PI * random.rand();
+					Vector3f b = e1 * std::cos(theta) + e2 * std::sin(theta); // real b-field vector
+
+					// normal distributed amplitude with mean = 0
+					b *= std::sqrt(spectrum.energySpectrum(k*lambda));
+
+					// uniform random phase
+					double phase = 2 * M_PI * random.rand();
+					double cosPhase = std::cos(phase); // real part
+					double sinPhase = std::sin(phase); // imaginary part
+
+					Bk[i][0] = b.data[component] * cosPhase;
+					Bk[i][1] = b.data[component] * sinPhase;
+				} // for iz
+			}     // for iy
+		}         // for ix
+
+		fftwf_execute(plan);
+		copyComponent(gridPtr, (float *)Bk, component);
+	}
+
+#pragma omp critical(FFTW)
+	fftwf_destroy_plan(plan);
+	fftwf_free(Bk);
 
 	scaleGrid(gridPtr, spectrum.getBrms() /
 	                       rmsFieldStrength(gridPtr)); // normalize to Brms
@@ -148,40 +231,21 @@ void GridTurbulence::executeInverseFFTInplace(ref_ptr<Grid3f> grid,
                                               fftwf_complex *Bkx,
                                               fftwf_complex *Bky,
                                               fftwf_complex *Bkz) {
-
-	size_t n = grid->getNx(); // size of array
-	size_t n2 = (size_t)floor(n / 2) +
-	            1; // size array in z-direction in configuration space
-
 	// in-place, complex to real, inverse Fourier transformation on each
 	// component note that the last elements of B(x) are unused now
-	float *Bx = (float *)Bkx;
-	fftwf_plan plan_x = fftwf_plan_dft_c2r_3d(n, n, n, Bkx, Bx, FFTW_ESTIMATE);
-	fftwf_execute(plan_x);
-	fftwf_destroy_plan(plan_x);
-
-	float *By = (float *)Bky;
-	fftwf_plan plan_y = fftwf_plan_dft_c2r_3d(n, n, n, Bky, By, FFTW_ESTIMATE);
-	fftwf_execute(plan_y);
-	fftwf_destroy_plan(plan_y);
-
-	float *Bz = (float *)Bkz;
-	fftwf_plan plan_z = fftwf_plan_dft_c2r_3d(n, n, n, Bkz, Bz, FFTW_ESTIMATE);
-	fftwf_execute(plan_z);
-	fftwf_destroy_plan(plan_z);
-
-	// save to grid
-	for (size_t ix = 0; ix < n; ix++) {
-		for (size_t iy = 0; iy < n; iy++) {
-			for (size_t iz = 0; iz < n; iz++) {
-				size_t i = ix * n * 2 * n2 + iy * 2 * n2 + iz;
-				Vector3f &b = grid->get(ix, iy, iz);
-				b.x = Bx[i];
-				b.y = By[i];
-				b.z = Bz[i];
-			}
-		}
-	}
+	executeInverseFFTInplace(grid, Bkx, 0);
+	executeInverseFFTInplace(grid, Bky, 1);
+	executeInverseFFTInplace(grid, Bkz, 2);
+}
+
+void GridTurbulence::executeInverseFFTInplace(ref_ptr<Grid3f> grid,
+                                              fftwf_complex *Bk,
+                                              int component) {
+	fftwf_plan plan = planInverseFFT(grid->getNx(), Bk, true);
+	fftwf_execute(plan);
+#pragma omp critical(FFTW)
+	fftwf_destroy_plan(plan);
+	copyComponent(grid, (float *)Bk, component);
 }
 
 Vector3f GridTurbulence::getMeanFieldVector() const {
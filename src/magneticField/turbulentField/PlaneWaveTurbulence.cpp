@@ -49,10 +49,10 @@
 #include <iostream>
 
 #if defined(FAST_WAVES)
-#if defined(__SSE__) && defined(__SSE2__) && defined(__SSE3__) && defined(__SSE4_1__) && defined(__SSE4_2__) && defined(__AVX__)
+#if defined(CRPROPA_HAVE_TARGET_DISPATCH) || defined(__AVX__)
 #define ENABLE_FAST_WAVES
 #else
-#error "FAST_WAVES is enabled, but it appears that not all required SIMD extensions are enabled in the compiler. Without these extensions, the FAST_WAVES optimization cannot be used. Please make sure that the SIMD_EXTENSIONS option in cmake matches the capabilities of your target CPU, or (if your target CPU does not support the required extensions), disable the FAST_WAVES flag in cmake."
+#error "FAST_WAVES is enabled, but the compiler can neither select the AVX kernels at runtime nor is AVX enabled at compile time. Please set the SIMD_EXTENSIONS option in cmake to a value matching the capabilities of your target CPU, or (if your target CPU does not support the required extensions), disable the FAST_WAVES flag in cmake."
 #endif
 #endif
 
@@ -64,9 +64,26 @@
 
 namespace crpropa {
 #ifdef ENABLE_FAST_WAVES
+// The kernels are compiled for AVX and AVX-512 independent of the compiler
+// flags, and the variant matching the CPU is selected at runtime. The AVX2+FMA
+// variant inlines the AVX kernel, which allows the compiler to fuse the
+// multiply-adds.
+#ifdef CRPROPA_HAVE_TARGET_DISPATCH
+#define FAST_WAVES_KERNEL static inline __attribute__((always_inline, target("avx")))
+#define FAST_WAVES_KERNEL_AVX512 static inline __attribute__((always_inline, target("avx512f")))
+#else
+#define FAST_WAVES_KERNEL static inline
+#define FAST_WAVES_KERNEL_AVX512 static inline
+#endif
+
+// the AVX-512 kernel needs a compiler supporting it
+#if defined(CRPROPA_HAVE_TARGET_DISPATCH) || defined(__AVX512F__)
+#define ENABLE_FAST_WAVES_AVX512
+#endif
+
 // see
 // https://stackoverflow.com/questions/49941645/get-sum-of-values-stored-in-m256d-with-sse-avx
-double hsum_double_avx(__m256d v) {
+FAST_WAVES_KERNEL double hsum_double_avx(__m256d v) {
 	__m128d vlow = _mm256_castpd256_pd128(v);
 	__m128d vhigh = _mm256_extractf128_pd(v, 1); // high 128
 	vlow = _mm_add_pd(vlow, vhigh);              // reduce down to 128
@@ -81,13 +98,19 @@ PlaneWaveTurbulence::PlaneWaveTurbulence(const TurbulenceSpectrum &spectrum,
     : TurbulentField(spectrum), Nm(Nm) {
 
 #ifdef ENABLE_FAST_WAVES
-	KISS_LOG_INFO << "PlaneWaveTurbulence: Using SIMD TD13 implementation"
-	              << std::endl;
-
-	// There used to be a cpuid check here, to see if the cpu running
-	// this code would support SIMD (SSE + AVX). However, the library providing
-	// the relevant function is no longer being used, and doing this manually
-	// might be a bit too much work.
+	simdLevel = getSimdLevel();
+	if (simdLevel >= SIMD_AVX) {
+		std::string name = simdLevelName(simdLevel);
+		KISS_LOG_INFO << "PlaneWaveTurbulence: Using SIMD TD13 implementation ("
+		              << name << ")" << std::endl;
+	} else {
+		KISS_LOG_WARNING << "PlaneWaveTurbulence: FAST_WAVES is enabled, but "
+		                 "AVX is not supported by the CPU or disabled by "
+		                 "setMaximumSimdLevel. Using the scalar "
+		                 "implementation." << std::endl;
+	}
+#else
+	simdLevel = SIMD_NONE;
 #endif
 
 	if (Nm <= 1) {
@@ -195,16 +218,19 @@ PlaneWaveTurbulence::PlaneWaveTurbulence(const TurbulenceSpectrum &spectrum,
 	// final step of the computation of each wavemode is multiplication by the
 	// amplitude, which will be set to 0, these padding wavemodes won't affect
 	// the result.
+	//
+	// The AVX-512 kernel reads 512 bits, or 8 doubles, aligned to 64 bytes at
+	// a time, so the arrays are padded and aligned for it in any case.
 
-	avx_Nm = ((Nm + 4 - 1) / 4) * 4; // round up to next larger multiple of 4:
-	                                 // align is 256 = 4 * sizeof(double) bit
-	avx_data = std::vector<double>(itotal * avx_Nm + 3, 0.);
+	avx_Nm = ((Nm + 8 - 1) / 8) * 8; // round up to next larger multiple of 8:
+	                                 // align is 512 = 8 * sizeof(double) bit
+	avx_data = std::vector<double>(itotal * avx_Nm + 7, 0.);
 
-	// get the first 256-bit aligned element
+	// get the first 512-bit aligned element
 	size_t size = avx_data.size() * sizeof(double);
 	void *pointer = avx_data.data();
 	align_offset =
-	    (double *)std::align(32, 32, pointer, size) - avx_data.data();
+	    (double *)std::align(64, 64, pointer, size) - avx_data.data();
 
 	// copy into the AVX arrays
 	for (int i = 0; i < Nm; i++) {
@@ -228,215 +254,378 @@ PlaneWaveTurbulence::PlaneWaveTurbulence(const TurbulenceSpectrum &spectrum,
 #endif // ENABLE_FAST_WAVES
 }
 
-Vector3d PlaneWaveTurbulence::getField(const Vector3d &pos) const {
-
-#ifndef ENABLE_FAST_WAVES
-	Vector3d B(0.);
-	for (int i = 0; i < Nm; i++) {
-		double z_ = pos.dot(kappa[i]);
-		B += xi[i] * Ak[i] * cos(k[i] * z_ + beta[i]);
-	}
-	return B;
+#ifdef ENABLE_FAST_WAVES
+// Computes cos(pi * x) for four values at once.
+FAST_WAVES_KERNEL __m256d cosPiAVX(__m256d cos_arg) {
+	// ********
+	// * Computing the cosine
+	// * Part 1: Argument reduction
+	//
+	//  To understand the computation of the cosine, first note that the
+	//  cosine is periodic and we thus only need to model its behavior
+	//  between 0 and 2*pi to be able compute the function anywhere. In
+	//  fact, by mirroring the function along the x and y axes, even the
+	//  range between 0 and pi/2 is sufficient for this purpose. In this
+	//  range, the cosine can be efficiently evaluated with high precision
+	//  by using a polynomial approximation. Thus, to compute the cosine,
+	//  the input value is first reduced so that it lies within this range.
+	//  Then, the polynomial approximation is evaluated. Finally, if
+	//  necessary, the sign of the result is flipped (mirroring the function
+	//  along the x axis).
+	//
+	//  The actual computation is slightly more involved. First, argument
+	//  reduction can be simplified drastically by computing cos(pi*x),
+	//  such that the values are reduced to the range [0, 0.5) instead of
+	//  [0, pi/2). Since the cosine is even (independent of the sign), we
+	//  can first reduce values to [-0.5, 0.5) – that is, a simple rounding
+	//  operation – and then neutralize the sign. In fact, precisely because
+	//  the cosine is even, all terms of the polynomial are powers of x^2,
+	//  so the value of x^2 (computed as x*x) forms the basis for the
+	//  polynomial approximation. If I understand things correctly, then (in
+	//  IEEE-754 floating point) x*x and (-x)*(-x) will always result in the
+	//  exact same value, which means that any error bound over [0, 0.5)
+	//  automatically applies to (-0.5, 0] as well.
+
+	// First, compute round(x), and store it in q. If this value is odd,
+	// we're looking at the negative half-wave of the cosine, and thus
+	// will have to invert the sign of the result.
+	__m256d q = _mm256_round_pd(
+	    cos_arg, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+
+	// Since we're computing cos(pi*x), round(x) always yields the center of
+	// a half-wave (where cos(pi*x) achieves an extremum). This point
+	// logically corresponds to x=0. Therefore, we subtract this center from
+	// the actual input argument to find the corresponding point on the
+	// half-wave that is centered around zero.
+	__m256d s = _mm256_sub_pd(cos_arg, q);
+
+	// We now want to check whether q (the index of our half-wave) is even
+	// or odd, since all of the odd-numbered half-waves are negative, so
+	// we'll have to flip the final result. On an int, this is as simple as
+	// checking the 0th bit. Idea: manipulate the double in such a way that
+	// we can do this. So, we add 2^52, such that the last digit of the
+	// mantissa is actually in the ones' position. Since q may be negative,
+	// we'll also add 2^51 to make sure it's positive. Note that 2^51 is
+	// even and thus leaves evenness invariant, which is the only thing we
+	// care about here.
+	//
+	// This is based on the int extraction process described here:
+	// https://stackoverflow.com/questions/41144668/how-to-efficiently-perform-double-int64-conversions-with-sse-avx/41223013
+	//
+	// We assume -2^51 <= q < 2^51 for this, which is unproblematic, as
+	// double precision has decayed far enough at that point that the
+	// usefulness of the cosine becomes limited.
+	//
+	// Explanation: The mantissa of a double-precision float has 52 bits
+	// (excluding the implicit first bit, which is always one). If |q| >
+	// 2^51, this implicit first bit has a place value of at least 2^51,
+	// while the first stored bit of the mantissa has a place value of at
+	// least 2^50. This means that the LSB of the mantissa has a place value
+	// of at least 2^(-1), or 0.5. For a cos(pi*x), this corresponds to a
+	// quarter of a cycle (pi/2), so at this point the precision of the
+	// input argument is so low that going from one representable number to
+	// the next causes the result to jump by +/-1.
+
+	q = _mm256_add_pd(q, _mm256_set1_pd(0x0018000000000000));
+
+	// Unfortunately, integer comparisons were only introduced in AVX2, so
+	// we'll have to make do with a floating point comparison to check
+	// whether the last bit is set. However, masking out all but the last
+	// bit will result in a denormal float, which may either result in
+	// performance problems or just be rounded down to zero, neither of
+	// which is what we want here. To fix this, we'll mask in not only bit
+	// 0, but also the exponent (and sign, but that doesn't matter) of q.
+	// Luckily, the exponent of q is guaranteed to have the fixed value of
+	// 1075 (corresponding to 2^52) after our addition.
+
+	__m256d invert = _mm256_and_pd(
+	    q, _mm256_castsi256_pd(_mm256_set1_epi64x(0xfff0000000000001)));
+
+	// If we did have a one in bit 0, our result will be equal to 2^52 + 1.
+	invert = _mm256_cmp_pd(
+	    invert, _mm256_castsi256_pd(_mm256_set1_epi64x(0x4330000000000001)),
+	    _CMP_EQ_OQ);
+
+	// Now we know whether to flip the sign of the result. However, remember
+	// that we're working on multiple values at a time, so an if statement
+	// won't be of much use here (plus it might perform badly). Instead,
+	// we'll make use of the fact that the result of the comparison is all
+	// ones if the comparison was true (i.e. q is odd and we need to flip
+	// the result), and all zeroes otherwise. If we now mask out all bits
+	// except the sign bit, we get something that, when xor'ed into our
+	// final result, will flip the sign exactly when q is odd.
+	invert = _mm256_and_pd(invert, _mm256_set1_pd(-0.0));
+	// (Note that the binary representation of -0.0 is all 0 bits, except
+	// for the sign bit, which is set to 1.)
+
+	// TODO: clamp floats between 0 and 1? This would ensure that we never
+	// see inf's, but maybe we want that, so that things dont just fail
+	// silently...
+
+	// * end of argument reduction
+	// *******
+
+	// ******
+	// * Evaluate the cosine using a polynomial approximation for the zeroth
+	// half-wave.
+	// * The coefficients for this were generated using sleefs gencoef.c.
+	// * These coefficients are probably far from optimal; however, they
+	// should be sufficient for this case.
+	s = _mm256_mul_pd(s, s);
+
+	__m256d u = _mm256_set1_pd(+0.2211852080653743946e+0);
+
+	u = _mm256_add_pd(_mm256_mul_pd(u, s),
+	                  _mm256_set1_pd(-0.1332560668688523853e+1));
+	u = _mm256_add_pd(_mm256_mul_pd(u, s),
+	                  _mm256_set1_pd(+0.4058509506474178075e+1));
+	u = _mm256_add_pd(_mm256_mul_pd(u, s),
+	                  _mm256_set1_pd(-0.4934797516664651162e+1));
+	u = _mm256_add_pd(_mm256_mul_pd(u, s), _mm256_set1_pd(1.));
+
+	// Then, flip the sign of each double for which invert is not zero.
+	// Since invert has only zero bits except for a possible one in bit 63,
+	// we can xor it onto our result to selectively invert the 63rd (sign)
+	// bit in each double where invert is set.
+	return _mm256_xor_pd(u, invert);
+
+	// * end computation of cosine
+	// **********
+}
 
-#else  // ENABLE_FAST_WAVES
+// Evaluates the field at P positions, looping over the wavemodes in blocks of
+// four. The wavemode data is loaded once per block and used for all positions.
+// data points to the aligned avx_data, which holds itotal arrays of avx_Nm
+// values each.
+template <int P>
+FAST_WAVES_KERNEL void getFieldsAVXKernel(const double *data, int avx_Nm,
+                                          const Vector3d *pos, Vector3d *B) {
+	const int iAxi0 = 0, iAxi1 = 1, iAxi2 = 2;
+	const int ikkappa0 = 3, ikkappa1 = 4, ikkappa2 = 5, ibeta = 6;
 
 	// Initialize accumulators
 	//
-	// There is one accumulator per component of the result vector.
-	// Note that each accumulator contains four numbers. At the end of
-	// the loop, each of these numbers will contain the sum of every
+	// There is one accumulator per component of the result vector and
+	// position. Note that each accumulator contains four numbers. At the end
+	// of the loop, each of these numbers will contain the sum of every
 	// fourth wavemode, starting at a different offset. In the end, each
 	// of the accumulator's numbers are added together (using
 	// hsum_double_avx), resulting in the total sum for that component.
-
-	__m256d acc0 = _mm256_setzero_pd();
-	__m256d acc1 = _mm256_setzero_pd();
-	__m256d acc2 = _mm256_setzero_pd();
-
-	// broadcast position into AVX registers
-	__m256d pos0 = _mm256_set1_pd(pos.x);
-	__m256d pos1 = _mm256_set1_pd(pos.y);
-	__m256d pos2 = _mm256_set1_pd(pos.z);
+	__m256d acc0[P], acc1[P], acc2[P];
+
+	// broadcast positions into AVX registers
+	__m256d pos0[P], pos1[P], pos2[P];
+	for (int p = 0; p < P; p++) {
+		acc0[p] = _mm256_setzero_pd();
+		acc1[p] = _mm256_setzero_pd();
+		acc2[p] = _mm256_setzero_pd();
+		pos0[p] = _mm256_set1_pd(pos[p].x);
+		pos1[p] = _mm256_set1_pd(pos[p].y);
+		pos2[p] = _mm256_set1_pd(pos[p].z);
+	}
 
 	for (int i = 0; i < avx_Nm; i += 4) {
 
 		// Load data from memory into AVX registers:
 		//  - the three components of the vector A * xi
-		__m256d Axi0 =
-		    _mm256_load_pd(avx_data.data() + i + align_offset + avx_Nm * iAxi0);
-		__m256d Axi1 =
-		    _mm256_load_pd(avx_data.data() + i + align_offset + avx_Nm * iAxi1);
-		__m256d Axi2 =
-		    _mm256_load_pd(avx_data.data() + i + align_offset + avx_Nm * iAxi2);
+		__m256d Axi0 = _mm256_load_pd(data + i + avx_Nm * iAxi0);
+		__m256d Axi1 = _mm256_load_pd(data + i + avx_Nm * iAxi1);
+		__m256d Axi2 = _mm256_load_pd(data + i + avx_Nm * iAxi2);
 
 		//  - the three components of the vector k * kappa
-		__m256d kkappa0 = _mm256_load_pd(avx_data.data() + i + align_offset +
-		                                 avx_Nm * ikkappa0);
-		__m256d kkappa1 = _mm256_load_pd(avx_data.data() + i + align_offset +
-		                                 avx_Nm * ikkappa1);
-		__m256d kkappa2 = _mm256_load_pd(avx_data.data() + i + align_offset +
-		                                 avx_Nm * ikkappa2);
+		__m256d kkappa0 = _mm256_load_pd(data + i + avx_Nm * ikkappa0);
+		__m256d kkappa1 = _mm256_load_pd(data + i + avx_Nm * ikkappa1);
+		__m256d kkappa2 = _mm256_load_pd(data + i + avx_Nm * ikkappa2);
 
 		//  - the phase beta.
-		__m256d beta =
-		    _mm256_load_pd(avx_data.data() + i + align_offset + avx_Nm * ibeta);
-
-		// Then, do the computation.
-
-		// This is the scalar product between k*kappa and pos:
-		__m256d z = _mm256_add_pd(_mm256_mul_pd(pos0, kkappa0),
-		                          _mm256_add_pd(_mm256_mul_pd(pos1, kkappa1),
-		                                        _mm256_mul_pd(pos2, kkappa2)));
-
-		// Here, the phase is added on. This is the argument of the cosine.
-		__m256d cos_arg = _mm256_add_pd(z, beta);
-
-		// ********
-		// * Computing the cosine
-		// * Part 1: Argument reduction
-		//
-		//  To understand the computation of the cosine, first note that the
-		//  cosine is periodic and we thus only need to model its behavior
-		//  between 0 and 2*pi to be able compute the function anywhere. In
-		//  fact, by mirroring the function along the x and y axes, even the
-		//  range between 0 and pi/2 is sufficient for this purpose. In this
-		//  range, the cosine can be efficiently evaluated with high precision
-		//  by using a polynomial approximation. Thus, to compute the cosine,
-		//  the input value is first reduced so that it lies within this range.
-		//  Then, the polynomial approximation is evaluated. Finally, if
-		//  necessary, the sign of the result is flipped (mirroring the function
-		//  along the x axis).
-		//
-		//  The actual computation is slightly more involved. First, argument
-		//  reduction can be simplified drastically by computing cos(pi*x),
-		//  such that the values are reduced to the range [0, 0.5) instead of
-		//  [0, pi/2). Since the cosine is even (independent of the sign), we
-		//  can first reduce values to [-0.5, 0.5) – that is, a simple rounding
-		//  operation – and then neutralize the sign. In fact, precisely because
-		//  the cosine is even, all terms of the polynomial are powers of x^2,
-		//  so the value of x^2 (computed as x*x) forms the basis for the
-		//  polynomial approximation. If I understand things correctly, then (in
-		//  IEEE-754 floating point) x*x and (-x)*(-x) will always result in the
-		//  exact same value, which means that any error bound over [0, 0.5)
-		//  automatically applies to (-0.5, 0] as well.
-
-		// First, compute round(x), and store it in q. If this value is odd,
-		// we're looking at the negative half-wave of the cosine, and thus
-		// will have to invert the sign of the result.
-		__m256d q = _mm256_round_pd(
-		    cos_arg, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
-
-		// Since we're computing cos(pi*x), round(x) always yields the center of
-		// a half-wave (where cos(pi*x) achieves an extremum). This point
-		// logically corresponds to x=0. Therefore, we subtract this center from
-		// the actual input argument to find the corresponding point on the
-		// half-wave that is centered around zero.
-		__m256d s = _mm256_sub_pd(cos_arg, q);
-
-		// We now want to check whether q (the index of our half-wave) is even
-		// or odd, since all of the odd-numbered half-waves are negative, so
-		// we'll have to flip the final result. On an int, this is as simple as
-		// checking the 0th bit. Idea: manipulate the double in such a way that
-		// we can do this. So, we add 2^52, such that the last digit of the
-		// mantissa is actually in the ones' position. Since q may be negative,
-		// we'll also add 2^51 to make sure it's positive. Note that 2^51 is
-		// even and thus leaves evenness invariant, which is the only thing we
-		// care about here.
-		//
-		// This is based on the int extraction process described here:
-		// https://stackoverflow.com/questions/41144668/how-to-efficiently-perform-double-int64-conversions-with-sse-avx/41223013
-		//
-		// We assume -2^51 <= q < 2^51 for this, which is unproblematic, as
-		// double precision has decayed far enough at that point that the
-		// usefulness of the cosine becomes limited.
-		//
-		// Explanation: The mantissa of a double-precision float has 52 bits
-		// (excluding the implicit first bit, which is always one). If |q| >
-		// 2^51, this implicit first bit has a place value of at least 2^51,
-		// while the first stored bit of the mantissa has a place value of at
-		// least 2^50. This means that the LSB of the mantissa has a place value
-		// of at least 2^(-1), or 0.5. For a cos(pi*x), this corresponds to a
-		// quarter of a cycle (pi/2), so at this point the precision of the
-		// input argument is so low that going from one representable number to
-		// the next causes the result to jump by +/-1.
-
-		q = _mm256_add_pd(q, _mm256_set1_pd(0x0018000000000000));
-
-		// Unfortunately, integer comparisons were only introduced in AVX2, so
-		// we'll have to make do with a floating point comparison to check
-		// whether the last bit is set. However, masking out all but the last
-		// bit will result in a denormal float, which may either result in
-		// performance problems or just be rounded down to zero, neither of
-		// which is what we want here. To fix this, we'll mask in not only bit
-		// 0, but also the exponent (and sign, but that doesn't matter) of q.
-		// Luckily, the exponent of q is guaranteed to have the fixed value of
-		// 1075 (corresponding to 2^52) after our addition.
-
-		__m256d invert = _mm256_and_pd(
-		    q, _mm256_castsi256_pd(_mm256_set1_epi64x(0xfff0000000000001)));
-
-		// If we did have a one in bit 0, our result will be equal to 2^52 + 1.
-		invert = _mm256_cmp_pd(
-		    invert, _mm256_castsi256_pd(_mm256_set1_epi64x(0x4330000000000001)),
-		    _CMP_EQ_OQ);
-
-		// Now we know whether to flip the sign of the result. However, remember
-		// that we're working on multiple values at a time, so an if statement
-		// won't be of much use here (plus it might perform badly). Instead,
-		// we'll make use of the fact that the result of the comparison is all
-		// ones if the comparison was true (i.e. q is odd and we need to flip
-		// the result), and all zeroes otherwise. If we now mask out all bits
-		// except the sign bit, we get something that, when xor'ed into our
-		// final result, will flip the sign exactly when q is odd.
-		invert = _mm256_and_pd(invert, _mm256_set1_pd(-0.0));
-		// (Note that the binary representation of -0.0 is all 0 bits, except
-		// for the sign bit, which is set to 1.)
-
-		// TODO: clamp floats between 0 and 1? This would ensure that we never
-		// see inf's, but maybe we want that, so that things dont just fail
-		// silently...
-
-		// * end of argument reduction
-		// *******
-
-		// ******
-		// * Evaluate the cosine using a polynomial approximation for the zeroth
-		// half-wave.
-		// * The coefficients for this were generated using sleefs gencoef.c.
-		// * These coefficients are probably far from optimal; however, they
-		// should be sufficient for this case.
-		s = _mm256_mul_pd(s, s);
-
-		__m256d u = _mm256_set1_pd(+0.2211852080653743946e+0);
-
-		u = _mm256_add_pd(_mm256_mul_pd(u, s),
-		                  _mm256_set1_pd(-0.1332560668688523853e+1));
-		u = _mm256_add_pd(_mm256_mul_pd(u, s),
-		                  _mm256_set1_pd(+0.4058509506474178075e+1));
-		u = _mm256_add_pd(_mm256_mul_pd(u, s),
-		                  _mm256_set1_pd(-0.4934797516664651162e+1));
-		u = _mm256_add_pd(_mm256_mul_pd(u, s), _mm256_set1_pd(1.));
-
-		// Then, flip the sign of each double for which invert is not zero.
-		// Since invert has only zero bits except for a possible one in bit 63,
-		// we can xor it onto our result to selectively invert the 63rd (sign)
-		// bit in each double where invert is set.
-		u = _mm256_xor_pd(u, invert);
-
-		// * end computation of cosine
-		// **********
-
-		// Finally, Ak*xi is multiplied on. Since this is a vector, the
-		// multiplication needs to be done for each of the three
-		// components, so it happens separately.
-		acc0 = _mm256_add_pd(_mm256_mul_pd(u, Axi0), acc0);
-		acc1 = _mm256_add_pd(_mm256_mul_pd(u, Axi1), acc1);
-		acc2 = _mm256_add_pd(_mm256_mul_pd(u, Axi2), acc2);
+		__m256d beta = _mm256_load_pd(data + i + avx_Nm * ibeta);
+
+		// Then, do the computation for each position.
+		for (int p = 0; p < P; p++) {
+			// This is the scalar product between k*kappa and pos:
+			__m256d z = _mm256_add_pd(_mm256_mul_pd(pos0[p], kkappa0),
+			                          _mm256_add_pd(_mm256_mul_pd(pos1[p], kkappa1),
+			                                        _mm256_mul_pd(pos2[p], kkappa2)));
+
+			// Here, the phase is added on. This is the argument of the cosine.
+			__m256d u = cosPiAVX(_mm256_add_pd(z, beta));
+
+			// Finally, Ak*xi is multiplied on. Since this is a vector, the
+			// multiplication needs to be done for each of the three
+			// components, so it happens separately.
+			acc0[p] = _mm256_add_pd(_mm256_mul_pd(u, Axi0), acc0[p]);
+			acc1[p] = _mm256_add_pd(_mm256_mul_pd(u, Axi1), acc1[p]);
+			acc2[p] = _mm256_add_pd(_mm256_mul_pd(u, Axi2), acc2[p]);
+		}
+	}
+
+	for (int p = 0; p < P; p++)
+		B[p] = Vector3d(hsum_double_avx(acc0[p]), hsum_double_avx(acc1[p]),
+		                hsum_double_avx(acc2[p]));
+}
+
+FAST_WAVES_KERNEL void getFieldsAVXLoop(const double *data, int avx_Nm,
+                                        const Vector3d *pos, Vector3d *B,
+                                        size_t n) {
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		getFieldsAVXKernel<4>(data, avx_Nm, pos + i, B + i);
+	switch (n - i) {
+	case 3:
+		getFieldsAVXKernel<3>(data, avx_Nm, pos + i, B + i);
+		break;
+	case 2:
+		getFieldsAVXKernel<2>(data, avx_Nm, pos + i, B + i);
+		break;
+	case 1:
+		getFieldsAVXKernel<1>(data, avx_Nm, pos + i, B + i);
+		break;
 	}
+}
+
+static void getFieldsAVX(const double *data, int avx_Nm, const Vector3d *pos,
+                         Vector3d *B, size_t n) CRPROPA_TARGET("avx");
+static void getFieldsAVX(const double *data, int avx_Nm, const Vector3d *pos,
+                         Vector3d *B, size_t n) {
+	getFieldsAVXLoop(data, avx_Nm, pos, B, n);
+}
+
+static void getFieldsAVX2FMA(const double *data, int avx_Nm,
+                             const Vector3d *pos, Vector3d *B,
+                             size_t n) CRPROPA_TARGET("avx2,fma");
+static void getFieldsAVX2FMA(const double *data, int avx_Nm,
+                             const Vector3d *pos, Vector3d *B, size_t n) {
+	getFieldsAVXLoop(data, avx_Nm, pos, B, n);
+}
+
+#ifdef ENABLE_FAST_WAVES_AVX512
+// Computes cos(pi * x) for eight values at once, see cosPiAVX for the
+// details. AVX-512F provides 64 bit integer operations, so the sign flip for
+// odd half-waves is derived directly from the lowest bit of q.
+FAST_WAVES_KERNEL_AVX512 __m512d cosPiAVX512(__m512d cos_arg) {
+	__m512d q = _mm512_roundscale_pd(
+	    cos_arg, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+	__m512d s = _mm512_sub_pd(cos_arg, q);
+
+	q = _mm512_add_pd(q, _mm512_set1_pd(0x0018000000000000));
+	__m512i invert = _mm512_slli_epi64(
+	    _mm512_and_si512(_mm512_castpd_si512(q), _mm512_set1_epi64(1)), 63);
+
+	s = _mm512_mul_pd(s, s);
+	__m512d u = _mm512_set1_pd(+0.2211852080653743946e+0);
+	u = _mm512_fmadd_pd(u, s, _mm512_set1_pd(-0.1332560668688523853e+1));
+	u = _mm512_fmadd_pd(u, s, _mm512_set1_pd(+0.4058509506474178075e+1));
+	u = _mm512_fmadd_pd(u, s, _mm512_set1_pd(-0.4934797516664651162e+1));
+	u = _mm512_fmadd_pd(u, s, _mm512_set1_pd(1.));
+
+	return _mm512_castsi512_pd(
+	    _mm512_xor_si512(_mm512_castpd_si512(u), invert));
+}
+
+// AVX-512 version of getFieldsAVXKernel, with blocks of eight wavemodes.
+template <int P>
+FAST_WAVES_KERNEL_AVX512 void getFieldsAVX512Kernel(const double *data,
+                                                    int avx_Nm,
+                                                    const Vector3d *pos,
+                                                    Vector3d *B) {
+	const int iAxi0 = 0, iAxi1 = 1, iAxi2 = 2;
+	const int ikkappa0 = 3, ikkappa1 = 4, ikkappa2 = 5, ibeta = 6;
+
+	__m512d acc0[P], acc1[P], acc2[P];
+	__m512d pos0[P], pos1[P], pos2[P];
+	for (int p = 0; p < P; p++) {
+		acc0[p] = _mm512_setzero_pd();
+		acc1[p] = _mm512_setzero_pd();
+		acc2[p] = _mm512_setzero_pd();
+		pos0[p] = _mm512_set1_pd(pos[p].x);
+		pos1[p] = _mm512_set1_pd(pos[p].y);
+		pos2[p] = _mm512_set1_pd(pos[p].z);
+	}
+
+	for (int i = 0; i < avx_Nm; i += 8) {
+		__m512d Axi0 = _mm512_load_pd(data + i + avx_Nm * iAxi0);
+		__m512d Axi1 = _mm512_load_pd(data + i + avx_Nm * iAxi1);
+		__m512d Axi2 = _mm512_load_pd(data + i + avx_Nm * iAxi2);
+		__m512d kkappa0 = _mm512_load_pd(data + i + avx_Nm * ikkappa0);
+		__m512d kkappa1 = _mm512_load_pd(data + i + avx_Nm * ikkappa1);
+		__m512d kkappa2 = _mm512_load_pd(data + i + avx_Nm * ikkappa2);
+		__m512d beta = _mm512_load_pd(data + i + avx_Nm * ibeta);
+
+		for (int p = 0; p < P; p++) {
+			__m512d cos_arg = _mm512_fmadd_pd(pos0[p], kkappa0,
+			                  _mm512_fmadd_pd(pos1[p], kkappa1,
+			                  _mm512_fmadd_pd(pos2[p], kkappa2, beta)));
+			__m512d u = cosPiAVX512(cos_arg);
+			acc0[p] = _mm512_fmadd_pd(u, Axi0, acc0[p]);
+			acc1[p] = _mm512_fmadd_pd(u, Axi1, acc1[p]);
+			acc2[p] = _mm512_fmadd_pd(u, Axi2, acc2[p]);
+		}
+	}
+
+	for (int p = 0; p < P; p++)
+		B[p] = Vector3d(_mm512_reduce_add_pd(acc0[p]),
+		                _mm512_reduce_add_pd(acc1[p]),
+		                _mm512_reduce_add_pd(acc2[p]));
+}
+
+static void getFieldsAVX512(const double *data, int avx_Nm,
+                            const Vector3d *pos, Vector3d *B,
+                            size_t n) CRPROPA_TARGET("avx512f");
+static void getFieldsAVX512(const double *data, int avx_Nm,
+                            const Vector3d *pos, Vector3d *B, size_t n) {
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		getFieldsAVX512Kernel<4>(data, avx_Nm, pos + i, B + i);
+	switch (n - i) {
+	case 3:
+		getFieldsAVX512Kernel<3>(data, avx_Nm, pos + i, B + i);
+		break;
+	case 2:
+		getFieldsAVX512Kernel<2>(data, avx_Nm, pos + i, B + i);
+		break;
+	case 1:
+		getFieldsAVX512Kernel<1>(data, avx_Nm, pos + i, B + i);
+		break;
+	}
+}
+#endif // ENABLE_FAST_WAVES_AVX512
+#endif // ENABLE_FAST_WAVES
+
+Vector3d PlaneWaveTurbulence::getField(const Vector3d &pos) const {
+	Vector3d B;
+	getFields(&pos, &B, 1);
+	return B;
+}
 
-	return Vector3d(hsum_double_avx(acc0), hsum_double_avx(acc1),
-	                hsum_double_avx(acc2));
+void PlaneWaveTurbulence::getFields(const Vector3d *positions, Vector3d *fields,
+                                    size_t n, double z) const {
+#ifdef ENABLE_FAST_WAVES
+	const double *data = avx_data.data() + align_offset;
+#ifdef ENABLE_FAST_WAVES_AVX512
+	if (simdLevel >= SIMD_AVX512) {
+		getFieldsAVX512(data, avx_Nm, positions, fields, n);
+		return;
+	}
+#endif
+	if (simdLevel >= SIMD_AVX2_FMA) {
+		getFieldsAVX2FMA(data, avx_Nm, positions, fields, n);
+		return;
+	}
+	if (simdLevel >= SIMD_AVX) {
+		getFieldsAVX(data, avx_Nm, positions, fields, n);
+		return;
+	}
 #endif // ENABLE_FAST_WAVES
+
+	for (size_t j = 0; j < n; j++) {
+		const Vector3d &pos = positions[j];
+		Vector3d B(0.);
+		for (int i = 0; i < Nm; i++) {
+			double z_ = pos.dot(kappa[i]);
+			B += xi[i] * Ak[i] * cos(k[i] * z_ + beta[i]);
+		}
+		fields[j] = B;
+	}
 }
 
 } // namespace crpropa
@@ -27,6 +27,7 @@
 
 // needed for memcpy in gcc 4.3.2
 #include <cstring>
+#include <algorithm>
 
 namespace crpropa 
 {
@@ -74,7 +75,7 @@ void MagneticLens::loadLens(const string &filename)
 }
 
 bool MagneticLens::transformCosmicRay(double rigidity, double& phi,
-		double& theta) 
+		double& theta) const
 {
 	uint32_t c = _pixelization->direction2Pix(phi, theta);
 	LensPart *lenspart = getLensPart(rigidity);
@@ -84,33 +85,49 @@ bool MagneticLens::transformCosmicRay(double rigidity, double& phi,
 		std::cerr << " This lens covers the range " << _minimumRigidity /eV << " eV - " << _maximumRigidity << " eV.\n";
 		return false;
 	}
-
-	ModelVectorType v = lenspart->getMatrix().col(c);
-
-	uint32_t r;
+	lenspart->ensureLoaded();
+	lenspart->checkColumnCDF();
 
 	// the random number to compare with
 	double rn = Random::instance().rand();
 
-	ModelVectorType::InnerIterator i(v);
-  double cpv = 0;
-  while (i)
-  {
-		cpv += i.value();
-		if (rn < cpv)
+	long r = lenspart->sampleRow(c, rn);
+	if (r < 0)
+		return false;
+	_pixelization->pix2Direction(r, phi, theta);
+	return true;
+}
+
+size_t MagneticLens::transformCosmicRays(double rigidity, double *phi,
+		double *theta, bool *survived, size_t n) const
+{
+	LensPart *lenspart = getLensPart(rigidity);
+	if (!lenspart)
+	{
+		std::cerr << "Warning. Trying to transform cosmic rays with rigidity " << rigidity / eV << " eV which is not covered by this lens!.\n";
+		std::fill(survived, survived + n, false);
+		return 0;
+	}
+	lenspart->ensureLoaded();
+	lenspart->checkColumnCDF();
+
+	long nSurvived = 0;
+#pragma omp parallel for reduction(+:nSurvived)
+	for (long i = 0; i < (long) n; i++)
+	{
+		uint32_t c = _pixelization->direction2Pix(phi[i], theta[i]);
+		long r = lenspart->sampleRow(c, Random::instance().rand());
+		survived[i] = (r >= 0);
+		if (survived[i])
 		{
-			_pixelization->pix2Direction(i.index(), phi, theta);
-			return true;
-    }
-    else
-    {
-			++i;
-    }
-   }
-  return false;
+			_pixelization->pix2Direction(r, phi[i], theta[i]);
+			nSurvived++;
+		}
+	}
+	return nSurvived;
 }
 
-bool MagneticLens::transformCosmicRay(double rigidity, Vector3d &p){
+bool MagneticLens::transformCosmicRay(double rigidity, Vector3d &p) const {
 
 			double galacticLongitude = atan2(-p.y, -p.x);
 			double galacticLatitude =	M_PI / 2 - acos(-p.z/ sqrt(p.x*p.x + p.y*p.y + p.z*p.z));
@@ -128,33 +145,40 @@ void MagneticLens::loadLensPart(const string &filename, double rigidityMin,
 {
 	updateRigidityBounds(rigidityMin, rigidityMax);
 
-	LensPart *p = new LensPart(filename, rigidityMin, rigidityMax);
-	p->loadMatrixFromFile();
-	_checkMatrix(p->getMatrix());
+	// the matrix itself is loaded on first use
+	uint32_t rows, cols;
+	deserializeSize(filename, rows, cols);
+	_checkMatrixSize(rows, cols);
 
+	LensPart *p = new LensPart(filename, rigidityMin, rigidityMax);
 	_lensParts.push_back(p);
 }
 
 void MagneticLens::_checkMatrix(const ModelMatrixType &M)
 {
-	if (M.rows() != M.cols())
+	_checkMatrixSize(M.rows(), M.cols());
+}
+
+void MagneticLens::_checkMatrixSize(uint32_t rows, uint32_t cols)
+{
+	if (rows != cols)
 	{
 		throw std::runtime_error("Not a square Matrix!");
 	}
 
 	if (_pixelization)
 	{
-		if (_pixelization->nPix() != M.cols())
+		if (_pixelization->nPix() != cols)
 		{
 			std::cerr << "*** ERROR ***" << endl;
 			std::cerr << "  Pixelization: " << _pixelization->nPix() << endl;
-			std::cerr << "  Matrix Size : " << M.cols() << endl;
+			std::cerr << "  Matrix Size : " << cols << endl;
 			throw std::runtime_error("Matrix doesn't fit into Lense");
 		}
 	}
 	else
 	{
-		uint32_t morder = Pixelization::pix2Order(M.cols());
+		uint32_t morder = Pixelization::pix2Order(cols);
 		if (morder == 0)
 		{
 			throw std::runtime_error(
@@ -223,6 +247,7 @@ void MagneticLens::normalizeMatrixColumns()
 			++iter)
 	{
 		normalizeColumns((*iter)->getMatrix());
+		(*iter)->updateColumnCDF();
 	}
 }
 
@@ -243,6 +268,7 @@ void MagneticLens::normalizeLens()
 			++iter)
 	{
 		normalizeMatrix((*iter)->getMatrix(), norm);
+		(*iter)->updateColumnCDF();
 	}
   _norm = norm;
 }
@@ -254,6 +280,7 @@ void MagneticLens::normalizeLensparts()
 	{
 		double norm = (*iter)->getMaximumOfSumsOfColumns();
 		normalizeMatrix((*iter)->getMatrix(), norm);
+		(*iter)->updateColumnCDF();
 	}
 }
 
@@ -271,6 +298,19 @@ void MagneticLens::transformModelVector(double* model, double rigidity) const
 
 }
 
+void MagneticLens::transformModelVectors(double* models, size_t nVectors, double rigidity) const
+{
+	LensPart* lenspart = getLensPart(rigidity);
+
+	if (!lenspart)
+	{
+		std::cerr << "Warning. Trying to transform vectors with rigidity " << rigidity / eV << "eV which is not covered by this lens!.\n" << std::endl;
+		return;
+	}
+
+	prod_up(lenspart->getMatrix(), models, nVectors);
+}
+
 
 
 } // namespace parsec
@@ -21,12 +21,32 @@
 //----------------------------------------------------------------------
 
 #include "crpropa/magneticLens/ModelMatrix.h"
+#include <algorithm>
+#include <limits>
 #include <ctime>
+#include <cstring>
 
 #include <Eigen/Core>
 namespace crpropa 
 {
 
+struct CompressedMatrixHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t rows;
+	uint64_t cols;
+	uint64_t nonZeros;
+};
+
+static const char compressedMatrixMagic[8] = "CRPCSC";
+static const uint32_t compressedMatrixVersion = 1;
+
+// the index arrays are written and read as they are stored in the matrix
+static_assert(sizeof(ModelMatrixType::StorageIndex) == sizeof(int32_t),
+		"ModelMatrixType has to use 32 bit indices");
+
 void serialize(const string &filename, const ModelMatrixType& matrix)
 {
 	ofstream outfile(filename.c_str(), ios::binary);
@@ -70,6 +90,83 @@ void serialize(const string &filename, const ModelMatrixType& matrix)
 }
 
 
+void serializeCompressed(const string &filename, const ModelMatrixType& matrix)
+{
+	ofstream outfile(filename.c_str(), ios::binary);
+	if (!outfile)
+	{
+		throw runtime_error("Can't write file: " + filename);
+	}
+
+	ModelMatrixType compressed(matrix);
+	compressed.makeCompressed();
+
+	CompressedMatrixHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, compressedMatrixMagic, sizeof(compressedMatrixMagic));
+	header.version = compressedMatrixVersion;
+	header.rows = compressed.rows();
+	header.cols = compressed.cols();
+	header.nonZeros = compressed.nonZeros();
+
+	outfile.write((char*) &header, sizeof(header));
+	outfile.write((char*) compressed.outerIndexPtr(), (header.cols + 1) * sizeof(int32_t));
+	outfile.write((char*) compressed.innerIndexPtr(), header.nonZeros * sizeof(int32_t));
+	outfile.write((char*) compressed.valuePtr(), header.nonZeros * sizeof(double));
+	if (outfile.fail())
+	{
+		throw runtime_error("Error writing file: " + filename);
+	}
+	outfile.close();
+}
+
+// size of the file in bytes, the read position is restored
+static uint64_t streamSize(ifstream &infile)
+{
+	std::streampos pos = infile.tellg();
+	infile.seekg(0, ios::end);
+	uint64_t size = infile.tellg();
+	infile.seekg(pos);
+	return size;
+}
+
+// returns true and fills the header if the file uses the compressed layout
+static bool readCompressedHeader(ifstream &infile, CompressedMatrixHeader &header)
+{
+	infile.read((char*) &header, sizeof(header));
+	if (infile && (memcmp(header.magic, compressedMatrixMagic, sizeof(compressedMatrixMagic)) == 0))
+		return true;
+	infile.clear();
+	infile.seekg(0);
+	return false;
+}
+
+void deserializeSize(const string &filename, uint32_t &rows, uint32_t &columns)
+{
+	ifstream infile(filename.c_str(), ios::binary);
+	if (!infile)
+	{
+		throw runtime_error("Can't read file: " + filename);
+	}
+
+	CompressedMatrixHeader header;
+	if (readCompressedHeader(infile, header))
+	{
+		rows = header.rows;
+		columns = header.cols;
+		return;
+	}
+
+	uint32_t nnz;
+	infile.read((char*) &nnz, sizeof(uint32_t));
+	infile.read((char*) &rows, sizeof(uint32_t));
+	infile.read((char*) &columns, sizeof(uint32_t));
+	if (infile.fail())
+	{
+		throw runtime_error("Error reading file: " + filename);
+	}
+}
+
 void deserialize(const string &filename, ModelMatrixType& matrix)
 {
 	ifstream infile(filename.c_str(), ios::binary);
@@ -78,10 +175,57 @@ void deserialize(const string &filename, ModelMatrixType& matrix)
 		throw runtime_error("Can't read file: " + filename);
 	}
 
+	CompressedMatrixHeader header;
+	if (readCompressedHeader(infile, header))
+	{
+		if (header.version != compressedMatrixVersion)
+		{
+			throw runtime_error("Unsupported matrix file version: " + filename);
+		}
+		// reject inconsistent headers before allocating any memory
+		const uint64_t maxIndex = std::numeric_limits<int32_t>::max();
+		if ((header.rows > maxIndex) || (header.cols >= maxIndex) || (header.nonZeros > maxIndex)
+				|| (streamSize(infile) != sizeof(header) + (header.cols + 1) * sizeof(int32_t)
+					+ header.nonZeros * (sizeof(int32_t) + sizeof(double))))
+		{
+			throw runtime_error("Corrupt matrix file: " + filename);
+		}
+
+		// read the compressed storage directly into the matrix
+		matrix.resize(header.rows, header.cols);
+		matrix.resizeNonZeros(header.nonZeros);
+		infile.read((char*) matrix.outerIndexPtr(), (header.cols + 1) * sizeof(int32_t));
+		infile.read((char*) matrix.innerIndexPtr(), header.nonZeros * sizeof(int32_t));
+		infile.read((char*) matrix.valuePtr(), header.nonZeros * sizeof(double));
+		if (infile.fail())
+		{
+			throw runtime_error("Error reading file: " + filename);
+		}
+
+		// the column offsets have to be ordered and the row indices in range
+		const int32_t *outer = matrix.outerIndexPtr();
+		const int32_t *inner = matrix.innerIndexPtr();
+		bool valid = (outer[0] == 0) && ((uint64_t) outer[header.cols] == header.nonZeros);
+		for (size_t j = 0; valid && (j < header.cols); j++)
+			valid = (outer[j] <= outer[j + 1]);
+		for (size_t i = 0; valid && (i < header.nonZeros); i++)
+			valid = (inner[i] >= 0) && ((uint64_t) inner[i] < header.rows);
+		if (!valid)
+		{
+			matrix.resize(0, 0);
+			throw runtime_error("Corrupt matrix file: " + filename);
+		}
+		return;
+	}
+
 	uint32_t nnz, nRows, nColumns;
 	infile.read((char*) &nnz, sizeof(uint32_t));
 	infile.read((char*) &nRows, sizeof(uint32_t));
 	infile.read((char*) &nColumns, sizeof(uint32_t));
+	if (infile.fail() || (streamSize(infile) != 3 * sizeof(uint32_t) + (uint64_t) nnz * (2 * sizeof(uint32_t) + sizeof(double))))
+	{
+		throw runtime_error("Corrupt matrix file: " + filename);
+	}
 	matrix.resize(nRows, nColumns);
 	matrix.reserve(nnz);
 
@@ -94,6 +238,10 @@ void deserialize(const string &filename, ModelMatrixType& matrix)
 		infile.read((char*) &row, sizeof(uint32_t));
 		infile.read((char*) &column, sizeof(uint32_t));
 		infile.read((char*) &val, sizeof(double));
+		if ((row >= nRows) || (column >= nColumns))
+		{
+			throw runtime_error("Corrupt matrix file: " + filename);
+		}
 		//M(size1,size2) = val;
 		triplets[i] = Eigen::Triplet<double>(row, column, val);
 	}
@@ -135,26 +283,93 @@ double maximumOfSumsOfColumns(const ModelMatrixType &matrix)
 	matrix /= norm;
 }
 
-	void prod_up(const ModelMatrixType& matrix, double* model)
+// scratch buffers of the matrix products, reused between calls of one thread
+static thread_local std::vector<double> prodInputBuffer;
+static thread_local std::vector<double> prodOutputBuffer;
+
+// y = matrix * x for K vectors stored interleaved in x and y, so that each
+// nonzero of the matrix is read once and applied with a contiguous inner loop
+template<size_t K>
+static void prodInterleaved(const ModelMatrixType& matrix, const double *x, double *y)
 {
+	for (size_t j = 0; j < (size_t)matrix.cols(); j++)
+	{
+		const double *xj = x + j * K;
+		for (ModelMatrixType::InnerIterator it(matrix, j); it; ++it)
+		{
+			double *yi = y + it.row() * K;
+			const double v = it.value();
+			for (size_t l = 0; l < K; l++)
+				yi[l] += v * xj[l];
+		}
+	}
+}
 
-	// copy storage of model, as matrix vector product cannot be done
-	// in place
-	
+// matrix product with update for k <= 8 consecutive vectors
+static void prodBlock(const ModelMatrixType& matrix, double* models, size_t k)
+{
 	const size_t mSize = matrix.cols();
-	double *origVectorStorage = new double[mSize];
-	memcpy(origVectorStorage, model, mSize * sizeof(double));
+	std::vector<double> &input = prodInputBuffer;
+	std::vector<double> &output = prodOutputBuffer;
 
+	if (k == 1)
+	{
+		output.resize(mSize);
+		Eigen::Map<const Eigen::VectorXd> x(models, mSize);
+		Eigen::Map<Eigen::VectorXd> y(&output[0], mSize);
+		y.noalias() = matrix * x;
+		std::copy(output.begin(), output.end(), models);
+		return;
+	}
 
+	input.resize(mSize * k);
+	output.assign(mSize * k, 0.);
+	for (size_t l = 0; l < k; l++)
+	{
+		const double *model = models + l * mSize;
+		for (size_t j = 0; j < mSize; j++)
+			input[j * k + l] = model[j];
+	}
 
-	Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, 1> > origVectorAdaptor(origVectorStorage, mSize);
-	Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, 1> > modelVectorAdaptor(model, mSize);
+	switch (k)
+	{
+	case 2: prodInterleaved<2>(matrix, &input[0], &output[0]); break;
+	case 3: prodInterleaved<3>(matrix, &input[0], &output[0]); break;
+	case 4: prodInterleaved<4>(matrix, &input[0], &output[0]); break;
+	case 5: prodInterleaved<5>(matrix, &input[0], &output[0]); break;
+	case 6: prodInterleaved<6>(matrix, &input[0], &output[0]); break;
+	case 7: prodInterleaved<7>(matrix, &input[0], &output[0]); break;
+	case 8: prodInterleaved<8>(matrix, &input[0], &output[0]); break;
+	default: throw std::runtime_error("prod_up: invalid block size");
+	}
 
-	// perform the optimized product
-	modelVectorAdaptor = matrix * origVectorAdaptor;
+	for (size_t l = 0; l < k; l++)
+	{
+		double *model = models + l * mSize;
+		for (size_t j = 0; j < mSize; j++)
+			model[j] = output[j * k + l];
+	}
+}
 
-	// clean up
-	delete[] origVectorStorage;
+	void prod_up(const ModelMatrixType& matrix, double* model)
+{
+	prodBlock(matrix, model, 1);
+}
+
+	void prod_up(const ModelMatrixType& matrix, double* models, size_t nVectors)
+{
+	// the vectors are processed in blocks of up to eight, distributed over the threads
+	const size_t blockSize = 8;
+	const size_t mSize = matrix.cols();
+	const size_t nBlocks = (nVectors + blockSize - 1) / blockSize;
+
+#pragma omp parallel for schedule(dynamic) if (nBlocks > 1)
+	for (long b = 0; b < (long)nBlocks; b++)
+	{
+		const size_t first = b * blockSize;
+		const size_t k = std::min(blockSize, nVectors - first);
+		prodBlock(matrix, models + first * mSize, k);
+	}
 }
 
 
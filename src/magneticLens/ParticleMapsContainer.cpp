@@ -3,19 +3,17 @@
 #include "crpropa/magneticLens/ParticleMapsContainer.h"
 #include "crpropa/Units.h"
 
+#include <algorithm>
+#include <climits>
 #include <iostream>
 #include <fstream>
+#include <stdexcept>
 
 namespace crpropa  {
 
 ParticleMapsContainer::~ParticleMapsContainer() {
-	for(std::map<int, std::map<int, double*> >::iterator pid_iter = _data.begin(); 
-			pid_iter != _data.end(); ++pid_iter) {
-		for(std::map<int, double*>::iterator energy_iter = pid_iter->second.begin();
-			energy_iter != pid_iter->second.end(); ++energy_iter) {
-			delete[] (energy_iter->second);
-		}
-	}
+	for (size_t i = 0; i < _maps.size(); i++)
+		delete[] _maps[i].data;
 }
 
 int ParticleMapsContainer::energy2Idx(double energy) const {
@@ -27,37 +25,49 @@ double ParticleMapsContainer::idx2Energy(int idx) const {
 	return pow(10, idx * _deltaLogE + _bin0lowerEdge + _deltaLogE / 2) * eV;
 }
 
+bool ParticleMapsContainer::mapBefore(const ParticleMap &m, const std::pair<int, int> &key) {
+	return (m.pid < key.first) || ((m.pid == key.first) && (m.energyIdx < key.second));
+}
+
+long ParticleMapsContainer::findMap(int pid, int energyIdx) const {
+	std::vector<ParticleMap>::const_iterator it = std::lower_bound(_maps.begin(), _maps.end(), std::make_pair(pid, energyIdx), mapBefore);
+	if ((it == _maps.end()) || (it->pid != pid) || (it->energyIdx != energyIdx))
+		return -1;
+	return it - _maps.begin();
+}
+
 		
 double* ParticleMapsContainer::getMap(const int particleId, double energy) {
 	_weightsUpToDate = false;
-	if (_data.find(particleId) == _data.end()) {
+	std::vector<ParticleMap>::iterator it = std::lower_bound(_maps.begin(), _maps.end(), std::make_pair(particleId, INT_MIN), mapBefore);
+	if ((it == _maps.end()) || (it->pid != particleId)) {
 		std::cerr << "No map for ParticleID " << particleId << std::endl;
 		return NULL;
 	}
-	int energyIdx	= energy2Idx(energy);
-	if (_data[particleId].find(energyIdx) == _data[particleId].end()) {
+	long i = findMap(particleId, energy2Idx(energy));
+	if (i < 0) {
 		std::cerr << "No map for ParticleID and energy" << energy / eV << " eV" << std::endl;
 		return NULL;
 	}
-	return _data[particleId][energy2Idx(energy)];
+	return _maps[i].data;
 }
 			
 			
 void ParticleMapsContainer::addParticle(const int particleId, double energy, double galacticLongitude, double galacticLatitude, double weight) {
 	_weightsUpToDate = false;
-	if (_data.find(particleId) == _data.end()) {
-		map<int, double*> M;
-		_data[particleId] = M;
-	}
-
 	int energyIdx	= energy2Idx(energy);
-	if (_data[particleId].find(energyIdx) == _data[particleId].end()) {
-		_data[particleId][energyIdx] = new double[_pixelization.getNumberOfPixels()];
-		std::fill(_data[particleId][energyIdx], _data[particleId][energyIdx] + _pixelization.getNumberOfPixels(), 0);
+	std::vector<ParticleMap>::iterator it = std::lower_bound(_maps.begin(), _maps.end(), std::make_pair(particleId, energyIdx), mapBefore);
+	if ((it == _maps.end()) || (it->pid != particleId) || (it->energyIdx != energyIdx)) {
+		ParticleMap m;
+		m.pid = particleId;
+		m.energyIdx = energyIdx;
+		m.data = new double[_pixelization.getNumberOfPixels()];
+		std::fill(m.data, m.data + _pixelization.getNumberOfPixels(), 0);
+		it = _maps.insert(it, m);
 	}
 
 	uint32_t pixel = _pixelization.direction2Pix(galacticLongitude, galacticLatitude);
-	_data[particleId][energyIdx][pixel] += weight;
+	it->data[pixel] += weight;
 }
 
 
@@ -70,9 +80,9 @@ void ParticleMapsContainer::addParticle(const int particleId, double energy, con
 
 std::vector<int> ParticleMapsContainer::getParticleIds() {
 	std::vector<int> ids;
-	for(std::map<int, std::map<int, double*> >::iterator pid_iter = _data.begin(); 
-			pid_iter != _data.end(); ++pid_iter) {
-		ids.push_back(pid_iter->first);
+	for (size_t i = 0; i < _maps.size(); i++) {
+		if (ids.empty() || (ids.back() != _maps[i].pid))
+			ids.push_back(_maps[i].pid);
 	}
 	return ids;
 }
@@ -80,12 +90,9 @@ std::vector<int> ParticleMapsContainer::getParticleIds() {
 
 std::vector<double> ParticleMapsContainer::getEnergies(int pid) {
 	std::vector<double> energies;
-	if (_data.find(pid) != _data.end()) {
-		for(std::map<int, double*>::iterator iter = _data[pid].begin(); 
-			iter != _data[pid].end(); ++iter) {
-			energies.push_back( idx2Energy(iter->first) / eV );
-		}
-	}
+	std::vector<ParticleMap>::iterator it = std::lower_bound(_maps.begin(), _maps.end(), std::make_pair(pid, INT_MIN), mapBefore);
+	for (; (it != _maps.end()) && (it->pid == pid); ++it)
+		energies.push_back( idx2Energy(it->energyIdx) / eV );
 	return energies;
 }
 
@@ -94,19 +101,15 @@ void ParticleMapsContainer::applyLens(MagneticLens &lens) {
 	// if lens is normalized, this should not be necessary.
 	_weightsUpToDate = false;
 
-	for(std::map<int, std::map<int, double*> >::iterator pid_iter = _data.begin(); 
-			pid_iter != _data.end(); ++pid_iter) {
-		for(std::map<int, double*>::iterator energy_iter = pid_iter->second.begin();
-			energy_iter != pid_iter->second.end(); ++energy_iter) {
-			// transform only nuclei
-			double energy = idx2Energy(energy_iter->first);
-			int chargeNumber = HepPID::Z(pid_iter->first);
-			if (chargeNumber != 0 && lens.rigidityCovered(energy / chargeNumber)) {
-				lens.transformModelVector(energy_iter->second, energy / chargeNumber);
-			} else { // still normalize the vectors 
-				for(size_t j=0; j< _pixelization.getNumberOfPixels() ; j++) {
-					energy_iter->second[j] /= lens.getNorm();
-				}
+	for (size_t i = 0; i < _maps.size(); i++) {
+		// transform only nuclei
+		double energy = idx2Energy(_maps[i].energyIdx);
+		int chargeNumber = HepPID::Z(_maps[i].pid);
+		if (chargeNumber != 0 && lens.rigidityCovered(energy / chargeNumber)) {
+			lens.transformModelVector(_maps[i].data, energy / chargeNumber);
+		} else { // still normalize the vectors 
+			for(size_t j=0; j< _pixelization.getNumberOfPixels() ; j++) {
+				_maps[i].data[j] /= lens.getNorm();
 			}
 		}
 	}
@@ -117,20 +120,26 @@ void ParticleMapsContainer::_updateWeights() {
 	if (_weightsUpToDate)
 		return;
 
-	for(std::map<int, std::map<int, double*> >::iterator pid_iter = _data.begin(); 
-			pid_iter != _data.end(); ++pid_iter) {
-		_weightsPID[pid_iter->first] = 0;
-
-		for(std::map<int, double*>::iterator energy_iter = pid_iter->second.begin();
-			energy_iter != pid_iter->second.end(); ++energy_iter)  {
-
-			_weights_pidEnergy[pid_iter->first][energy_iter->first] = 0;
-			for(size_t j = 0; j< _pixelization.getNumberOfPixels() ; j++) {
-				_weights_pidEnergy[pid_iter->first][energy_iter->first] +=energy_iter->second[j];
-				_weightsPID[pid_iter->first]+=energy_iter->second[j];
-			}
-			_sumOfWeights+=_weights_pidEnergy[pid_iter->first][energy_iter->first];
+	const size_t nPix = _pixelization.getNumberOfPixels();
+	_weights.resize(_maps.size());
+	_cumulativeWeights.resize(_maps.size());
+	_cumulativePixels.resize(_maps.size() * nPix);
+
+#pragma omp parallel for schedule(static)
+	for (long i = 0; i < (long)_maps.size(); i++) {
+		double *cdf = &_cumulativePixels[i * nPix];
+		double sum = 0;
+		for (size_t j = 0; j < nPix; j++) {
+			sum += _maps[i].data[j];
+			cdf[j] = sum;
 		}
+		_weights[i] = sum;
+	}
+
+	_sumOfWeights = 0;
+	for (size_t i = 0; i < _maps.size(); i++) {
+		_sumOfWeights += _weights[i];
+		_cumulativeWeights[i] = _sumOfWeights;
 	}
 	_weightsUpToDate = true;
 }
@@ -140,30 +149,29 @@ void ParticleMapsContainer::getRandomParticles(size_t N, vector<int> &particleId
 	vector<double> &energy, vector<double> &galacticLongitudes,
 	vector<double> &galacticLatitudes) {
 	_updateWeights();
+	if (!(_sumOfWeights > 0))
+		throw std::runtime_error("ParticleMapsContainer: no particles to draw from");
 
 	particleId.resize(N);
 	energy.resize(N);
 	galacticLongitudes.resize(N);
 	galacticLatitudes.resize(N);
 
-	for(size_t i=0; i< N; i++) {
-		//get particle
-		double r = Random::instance().rand() * _sumOfWeights;
-		std::map<int, double>::iterator iter = _weightsPID.begin();
-		while ((r-= iter->second) > 0) {
-			++iter; 
-		}
-		particleId[i] = iter->first;
-	
-		//get energy
-		r = Random::instance().rand() * iter->second;
-		iter = _weights_pidEnergy[particleId[i]].begin();
-		while ((r-= iter->second) > 0) {
-		 ++iter; 
-		}
-		energy[i] = idx2Energy(iter->first) / eV;
-
-		placeOnMap(particleId[i], energy[i] * eV, galacticLongitudes[i], galacticLatitudes[i]);
+	// r can round up to the sum of weights, then the last map with a
+	// non-zero weight is drawn instead of running past the end
+	const size_t lastMap = std::lower_bound(_cumulativeWeights.begin(), _cumulativeWeights.end(), _sumOfWeights) - _cumulativeWeights.begin();
+
+#pragma omp parallel for schedule(static)
+	for (long i = 0; i < (long)N; i++) {
+		// get particle and energy
+		double r = Random::instance().randExc() * _sumOfWeights;
+		size_t mapIdx = std::upper_bound(_cumulativeWeights.begin(), _cumulativeWeights.end(), r) - _cumulativeWeights.begin();
+		if (mapIdx > lastMap)
+			mapIdx = lastMap;
+		particleId[i] = _maps[mapIdx].pid;
+		energy[i] = idx2Energy(_maps[mapIdx].energyIdx) / eV;
+
+		_placeOnMap(mapIdx, galacticLongitudes[i], galacticLatitudes[i]);
 	}
 }
 
@@ -171,24 +179,27 @@ void ParticleMapsContainer::getRandomParticles(size_t N, vector<int> &particleId
 bool ParticleMapsContainer::placeOnMap(int pid, double energy, double &galacticLongitude, double &galacticLatitude) {
 	_updateWeights();
 
-	if (_data.find(pid) == _data.end()) {
+	long i = findMap(pid, energy2Idx(energy));
+	if (i < 0) {
 		return false;
 	}
-	int energyIdx	= energy2Idx(energy);
-	if (_data[pid].find(energyIdx) == _data[pid].end()) {
+	return _placeOnMap(i, galacticLongitude, galacticLatitude);
+}
+
+
+bool ParticleMapsContainer::_placeOnMap(size_t mapIdx, double &galacticLongitude, double &galacticLatitude) {
+	if (!(_weights[mapIdx] > 0))
 		return false;
-	}
 
-	double r = Random::instance().rand() * _weights_pidEnergy[pid][energyIdx];
+	const size_t nPix = _pixelization.getNumberOfPixels();
+	const double *cdf = &_cumulativePixels[mapIdx * nPix];
+	double r = Random::instance().randExc() * _weights[mapIdx];
+	size_t j = std::upper_bound(cdf, cdf + nPix, r) - cdf;
+	if (j == nPix) // rounded up, use the last pixel with a non-zero value
+		j = std::lower_bound(cdf, cdf + nPix, cdf[nPix - 1]) - cdf;
 
-	for(size_t j = 0; j< _pixelization.getNumberOfPixels(); j++) {
-		r -= _data[pid][energyIdx][j];
-		if (r <= 0) {
-			_pixelization.getRandomDirectionInPixel(j, galacticLongitude, galacticLatitude);
-			return true;
-		}
-	}
-	return false;
+	_pixelization.getRandomDirectionInPixel(j, galacticLongitude, galacticLatitude);
+	return true;
 }
 
 
@@ -174,9 +174,7 @@ void ParticleSplitting::process(Candidate *candidate) const {
 		// before the split are not affected
 		ref_ptr<Candidate> new_candidate = candidate->clone(false);
 		new_candidate->parent = candidate;
-		uint64_t snr = Candidate::getNextSerialNumber();
-		Candidate::setNextSerialNumber(snr + 1);
-		new_candidate->setSerialNumber(snr);
+		new_candidate->setSerialNumber(Candidate::allocateSerialNumber());
 		candidate->addSecondary(new_candidate);
 	}
 };
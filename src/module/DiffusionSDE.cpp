@@ -99,6 +99,10 @@ void DiffusionSDE::process(Candidate *candidate) const {
 	Vector3d DirOut = Vector3d(0.);
 
 
+	// the field at the initial position is shared by all trial steps and
+	// taken from the candidate, which caches it for the other modules
+	Vector3d BIn = getMagneticFieldAtPosition(PosIn, z, candidate);
+
 	double propTime = TStep * sqrt(h) / c_light;
 	size_t counter = 0;
 	double r=42.; //arbitrary number larger than one
@@ -106,7 +110,7 @@ void DiffusionSDE::process(Candidate *candidate) const {
 	do {
 		Vector3d PosOut = Vector3d(0.);
 		Vector3d PosErr = Vector3d(0.);
-	  	tryStep(PosIn, PosOut, PosErr, z, propTime);
+	  	tryStep(PosIn, BIn, PosOut, PosErr, z, propTime);
 	    // calculate the relative position error r and the next time step h
 	  	r = PosErr.getR() / tolerance;
 	  	propTime *= 0.5;
@@ -122,7 +126,10 @@ void DiffusionSDE::process(Candidate *candidate) const {
 	Vector3d PosOut = Vector3d(0.);
 	Vector3d PosErr = Vector3d(0.);
 	for (size_t j=0; j<stepNumber; j++) {
-		tryStep(Start, PosOut, PosErr, z, allowedTime);
+		if (j == 0)
+			tryStep(Start, BIn, PosOut, PosErr, z, allowedTime);
+		else
+			tryStep(Start, PosOut, PosErr, z, allowedTime);
 		Start = PosOut;
 	}
 
@@ -231,6 +238,10 @@ void DiffusionSDE::process(Candidate *candidate) const {
 
 
 void DiffusionSDE::tryStep(const Vector3d &PosIn, Vector3d &POut, Vector3d &PosErr,double z, double propStep) const {
+	tryStep(PosIn, getMagneticFieldAtPosition(PosIn, z), POut, PosErr, z, propStep);
+}
+
+void DiffusionSDE::tryStep(const Vector3d &PosIn, const Vector3d &BIn, Vector3d &POut, Vector3d &PosErr, double z, double propStep) const {
 
 	Vector3d k[] = {Vector3d(0.),Vector3d(0.),Vector3d(0.),Vector3d(0.),Vector3d(0.),Vector3d(0.)};
 	POut = PosIn;
@@ -242,7 +253,7 @@ void DiffusionSDE::tryStep(const Vector3d &PosIn, Vector3d &POut, Vector3d &PosE
 		  y_n += k[j] * a[i * 6 + j] * propStep;
 
 		// update k_i = direction of the regular magnetic mean field
-		Vector3d BField = getMagneticFieldAtPosition(y_n, z);
+		Vector3d BField = (i == 0) ? BIn : getMagneticFieldAtPosition(y_n, z);
 
 		k[i] = BField.getUnitVector() * c_light;
 
@@ -364,6 +375,19 @@ Vector3d DiffusionSDE::getMagneticFieldAtPosition(Vector3d pos, double z) const
 	return B;
 }
 
+Vector3d DiffusionSDE::getMagneticFieldAtPosition(Vector3d pos, double z, Candidate *candidate) const {
+	Vector3d B(0, 0, 0);
+	try {
+		if (magneticField.valid())
+			B = candidate->getMagneticField(magneticField, pos, z);
+	}
+	catch (std::exception &e) {
+		KISS_LOG_ERROR 	<< "DiffusionSDE: Exception in DiffusionSDE::getMagneticFieldAtPosition.\n"
+				<< e.what();
+	}
+	return B;
+}
+
 ref_ptr<AdvectionField> DiffusionSDE::getAdvectionField() const {
 	return advectionField;
 }
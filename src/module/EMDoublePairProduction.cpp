@@ -1,6 +1,7 @@
 #include "crpropa/module/EMDoublePairProduction.h"
 #include "crpropa/Units.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 
 #include <fstream>
 #include <limits>
@@ -35,27 +36,17 @@ void EMDoublePairProduction::setThinning(double thinning) {
 }
 
 void EMDoublePairProduction::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error("EMDoublePairProduction: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded interaction rates
 	tabEnergy.clear();
 	tabRate.clear();
 
-	while (infile.good()) {
-		if (infile.peek() != '#') {
-			double a, b;
-			infile >> a >> b;
-			if (infile) {
-				tabEnergy.push_back(pow(10, a) * eV);
-				tabRate.push_back(b / Mpc);
-			}
-		}
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 2);
+		tabEnergy.push_back(pow(10, row[0]) * eV);
+		tabRate.push_back(row[1] / Mpc);
 	}
-	infile.close();
 }
 
 
@@ -120,11 +111,11 @@ void EMDoublePairProduction::process(Candidate *candidate) const {
 }
 
 void EMDoublePairProduction::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string EMDoublePairProduction::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 
@@ -1,6 +1,7 @@
 #include "crpropa/module/EMInverseComptonScattering.h"
 #include "crpropa/Units.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/Common.h"
 
 #include <fstream>
@@ -11,11 +12,15 @@ namespace crpropa {
 
 static const double mec2 = mass_electron * c_squared;
 
+class ICSSecondariesEnergyDistribution;
+static const ICSSecondariesEnergyDistribution &icsSecondariesEnergyDistribution();
+
 EMInverseComptonScattering::EMInverseComptonScattering(ref_ptr<PhotonField> photonField, bool havePhotons, double thinning, double limit) {
 	setPhotonField(photonField);
 	setHavePhotons(havePhotons);
 	setLimit(limit);
 	setThinning(thinning);
+	icsSecondariesEnergyDistribution();
 }
 
 void EMInverseComptonScattering::setPhotonField(ref_ptr<PhotonField> photonField) {
@@ -39,72 +44,50 @@ void EMInverseComptonScattering::setThinning(double thinning) {
 }
 
 void EMInverseComptonScattering::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error("EMInverseComptonScattering: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded tables
 	tabEnergy.clear();
 	tabRate.clear();
 
-	while (infile.good()) {
-		if (infile.peek() != '#') {
-			double a, b;
-			infile >> a >> b;
-			if (infile) {
-				tabEnergy.push_back(pow(10, a) * eV);
-				tabRate.push_back(b / Mpc);
-			}
-		}
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 2);
+		tabEnergy.push_back(pow(10, row[0]) * eV);
+		tabRate.push_back(row[1] / Mpc);
 	}
-	infile.close();
 }
 
 void EMInverseComptonScattering::initCumulativeRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error("EMInverseComptonScattering: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded tables
 	tabE.clear();
 	tabs.clear();
 	tabCDF.clear();
-	
-	// skip header
-	while (infile.peek() == '#')
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
-
-	// read s values in first line
-	double a;
-	infile >> a; // skip first value
-	while (infile.good() and (infile.peek() != '\n')) {
-		infile >> a;
-		tabs.push_back(pow(10, a) * eV * eV);
-	}
 
-	// read all following lines: E, cdf values
-	while (infile.good()) {
-		infile >> a;
-		if (!infile)
-			break;  // end of file
-		tabE.push_back(pow(10, a) * eV);
-		std::vector<double> cdf;
-		for (int i = 0; i < tabs.size(); i++) {
-			infile >> a;
-			cdf.push_back(a / Mpc);
-		}
+	if (table->rows() == 0)
+		return;
+
+	// s values in first row, skip first value
+	const double *row = table->row(0);
+	for (size_t j = 1; j < table->rowSize(0); j++)
+		tabs.push_back(pow(10, row[j]) * eV * eV);
+
+	// all following rows: E, cdf values
+	for (size_t i = 1; i < table->rows(); i++) {
+		row = table->row(i, tabs.size() + 1);
+		tabE.push_back(pow(10, row[0]) * eV);
+		std::vector<double> cdf(tabs.size());
+		for (size_t j = 0; j < tabs.size(); j++)
+			cdf[j] = row[j + 1] / Mpc;
 		tabCDF.push_back(cdf);
 	}
-	infile.close();
 }
 
 // Class to calculate the energy distribution of the ICS photon and to sample from it
 class ICSSecondariesEnergyDistribution {
 	private:
-		std::vector< std::vector<double> > data;
+		std::vector<double> data; // cumulative distributions of all s bins, row by row
 		std::vector<double> s_values;
 		size_t Ns;
 		size_t Nrer;
@@ -114,7 +97,7 @@ class ICSSecondariesEnergyDistribution {
 
 	public:
 		// differential cross-section, see Lee '96 (arXiv:9604098), eq. 23 for x = Ee'/Ee
-		double dSigmadE(double x, double beta) {
+		static double dSigmadE(double x, double beta) {
 			double q = ((1 - beta) / beta) * (1 - 1./x);
 			return ((1 + beta) / beta) * (x + 1./x + 2 * q + q * q);
 		}
@@ -126,8 +109,7 @@ class ICSSecondariesEnergyDistribution {
 			s_min = mec2 * mec2;
 			s_max = 2e23 * eV * eV;
 			dls = (log(s_max) - log(s_min)) / Ns;
-			data = std::vector< std::vector<double> >(1000, std::vector<double>(1000));
-			std::vector<double> data_i(1000);
+			data = std::vector<double>(Ns * Nrer);
 
 			// tabulate s bin borders
 			s_values = std::vector<double>(1001);
@@ -143,6 +125,7 @@ class ICSSecondariesEnergyDistribution {
 				double dlx = -log(x0) / Nrer;
 
 				// cumulative midpoint integration
+				double *data_i = &data[i * Nrer];
 				data_i[0] = dSigmadE(x0, beta) * expm1(dlx);
 				for (size_t j = 1; j < Nrer; j++) {
 					double x = x0 * exp((j+0.5) * dlx);
@@ -150,16 +133,15 @@ class ICSSecondariesEnergyDistribution {
 					data_i[j] = dSigmadE(x, beta) * dx;
 					data_i[j] += data_i[j-1];
 				}
-				data[i] = data_i;
 			}
 		}
 
 		// draw random energy for the up-scattered photon Ep(Ee, s)
-		double sample(double Ee, double s) {
+		double sample(double Ee, double s) const {
 			size_t idx = std::lower_bound(s_values.begin(), s_values.end(), s) - s_values.begin();
-			std::vector<double> s0 = data[idx];
+			idx = std::min(idx, Ns - 1);
 			Random &random = Random::instance();
-			size_t j = random.randBin(s0) + 1; // draw random bin (upper bin boundary returned)
+			size_t j = random.randBin(&data[idx * Nrer], Nrer) + 1; // draw random bin (upper bin boundary returned)
 			double beta = (s - s_min) / (s + s_min);
 			double x0 = (1 - beta) / (1 + beta);
 			double dlx = -log(x0) / Nrer;
@@ -169,6 +151,12 @@ class ICSSecondariesEnergyDistribution {
 		}
 };
 
+// the distribution is tabulated once, on the construction of the first module
+static const ICSSecondariesEnergyDistribution &icsSecondariesEnergyDistribution() {
+	static ICSSecondariesEnergyDistribution distribution;
+	return distribution;
+}
+
 void EMInverseComptonScattering::performInteraction(Candidate *candidate) const {
 	// scale the particle energy instead of background photons
 	double z = candidate->getRedshift();
@@ -185,8 +173,7 @@ void EMInverseComptonScattering::performInteraction(Candidate *candidate) const
 	double s = s_kin + mec2 * mec2;
 
 	// sample electron energy after scattering
-	static ICSSecondariesEnergyDistribution distribution;
-	double Enew = distribution.sample(E, s);
+	double Enew = icsSecondariesEnergyDistribution().sample(E, s);
 
 	// add up-scattered photon
 	if (havePhotons) {
@@ -239,11 +226,11 @@ void EMInverseComptonScattering::process(Candidate *candidate) const {
 }
 
 void EMInverseComptonScattering::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string EMInverseComptonScattering::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 } // namespace crpropa
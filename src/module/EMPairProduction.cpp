@@ -1,6 +1,7 @@
 #include "crpropa/module/EMPairProduction.h"
 #include "crpropa/Units.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 #include "kiss/logger.h"
 
 #include <fstream>
@@ -12,6 +13,9 @@ namespace crpropa {
 
 static const double mec2 = mass_electron * c_squared;
 
+class PPSecondariesEnergyDistribution;
+static const PPSecondariesEnergyDistribution &ppSecondariesEnergyDistribution();
+
 EMPairProduction::EMPairProduction(ref_ptr<PhotonField> photonField, bool haveElectrons, double thinning, double limit) {
 	setPhotonField(photonField);
 	setThinning(thinning);
@@ -29,6 +33,8 @@ void EMPairProduction::setPhotonField(ref_ptr<PhotonField> photonField) {
 
 void EMPairProduction::setHaveElectrons(bool haveElectrons) {
 	this->haveElectrons = haveElectrons;
+	if (haveElectrons)
+		ppSecondariesEnergyDistribution();
 }
 
 void EMPairProduction::setLimit(double limit) {
@@ -40,78 +46,57 @@ void EMPairProduction::setThinning(double thinning) {
 }
 
 void EMPairProduction::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error("EMPairProduction: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded interaction rates
 	tabEnergy.clear();
 	tabRate.clear();
 
-	while (infile.good()) {
-		if (infile.peek() != '#') {
-			double a, b;
-			infile >> a >> b;
-			if (infile) {
-				tabEnergy.push_back(pow(10, a) * eV);
-				tabRate.push_back(b / Mpc);
-			}
-		}
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 2);
+		tabEnergy.push_back(pow(10, row[0]) * eV);
+		tabRate.push_back(row[1] / Mpc);
 	}
-	infile.close();
 }
 
 void EMPairProduction::initCumulativeRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error("EMPairProduction: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded tables
 	tabE.clear();
 	tabs.clear();
 	tabCDF.clear();
-	
-	// skip header
-	while (infile.peek() == '#')
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
-
-	// read s values in first line
-	double a;
-	infile >> a; // skip first value
-	while (infile.good() and (infile.peek() != '\n')) {
-		infile >> a;
-		tabs.push_back(pow(10, a) * eV * eV);
-	}
 
-	// read all following lines: E, cdf values
-	while (infile.good()) {
-		infile >> a;
-		if (!infile)
-			break;  // end of file
-		tabE.push_back(pow(10, a) * eV);
-		std::vector<double> cdf;
-		for (int i = 0; i < tabs.size(); i++) {
-			infile >> a;
-			cdf.push_back(a / Mpc);
-		}
+	if (table->rows() == 0)
+		return;
+
+	// s values in first row, skip first value
+	const double *row = table->row(0);
+	for (size_t j = 1; j < table->rowSize(0); j++)
+		tabs.push_back(pow(10, row[j]) * eV * eV);
+
+	// all following rows: E, cdf values
+	for (size_t i = 1; i < table->rows(); i++) {
+		row = table->row(i, tabs.size() + 1);
+		tabE.push_back(pow(10, row[0]) * eV);
+		std::vector<double> cdf(tabs.size());
+		for (size_t j = 0; j < tabs.size(); j++)
+			cdf[j] = row[j + 1] / Mpc;
 		tabCDF.push_back(cdf);
 	}
-	infile.close();
 }
 
 // Hold an data array to interpolate the energy distribution on
 class PPSecondariesEnergyDistribution {
 	private:
 		std::vector<double> tab_s;
-		std::vector< std::vector<double> > data;
+		std::vector<double> data; // cumulative distributions of all s bins, row by row
 		size_t N;
+		size_t Ns;
 
 	public:
 		// differential cross section for pair production for x = Epositron/Egamma, compare Lee 96 arXiv:9604098
-		double dSigmadE_PPx(double x, double beta) {
+		static double dSigmadE_PPx(double x, double beta) {
 			double A = (x / (1. - x) + (1. - x) / x );
 			double B =  (1. / x + 1. / (1. - x) );
 			double y = (1 - beta * beta);
@@ -120,11 +105,11 @@ class PPSecondariesEnergyDistribution {
 
 		PPSecondariesEnergyDistribution() {
 			N = 1000;
-			size_t Ns = 1000;
+			Ns = 1000;
 			double s_min = 4 * mec2 * mec2;
 			double s_max = 1e23 * eV * eV;
 			double dls = log(s_max / s_min) / Ns;
-			data = std::vector< std::vector<double> >(Ns, std::vector<double>(N));
+			data = std::vector<double>(Ns * N);
 			tab_s = std::vector<double>(Ns + 1);
 
 			for (size_t i = 0; i < Ns + 1; ++i)
@@ -137,29 +122,26 @@ class PPSecondariesEnergyDistribution {
 				double dx = log((1 + beta) / (1 - beta)) / N;
 
 				// cumulative midpoint integration
-				std::vector<double> data_i(1000);
+				double *data_i = &data[i * N];
 				data_i[0] = dSigmadE_PPx(x0, beta) * expm1(dx);
 				for (size_t j = 1; j < N; j++) {
 					double x = x0 * exp(j*dx + 0.5*dx);
 					double binWidth = exp((j+1)*dx)-exp(j*dx);
 					data_i[j] = dSigmadE_PPx(x, beta) * binWidth + data_i[j-1];
 				}
-				data[i] = data_i;
 			}
 		}
 
 		// sample positron energy from cdf(E, s_kin)
-		double sample(double E0, double s) {
+		double sample(double E0, double s) const {
 			// get distribution for given s
 			size_t idx = std::lower_bound(tab_s.begin(), tab_s.end(), s) - tab_s.begin();
-			if (idx > data.size())
+			if (idx >= Ns)
 				return NAN;
-				
-			std::vector<double> s0 = data[idx];
 
 			// draw random bin
 			Random &random = Random::instance();
-			size_t j = random.randBin(s0) + 1;
+			size_t j = random.randBin(&data[idx * N], N) + 1;
 
 			double s_min = 4. * mec2 * mec2;
 			double beta = sqrtl(1. - s_min / s);
@@ -173,6 +155,12 @@ class PPSecondariesEnergyDistribution {
 		}
 };
 
+// the distribution is tabulated once, on the construction of the first module that needs it
+static const PPSecondariesEnergyDistribution &ppSecondariesEnergyDistribution() {
+	static PPSecondariesEnergyDistribution distribution;
+	return distribution;
+}
+
 void EMPairProduction::performInteraction(Candidate *candidate) const {
 	
 	// photon is lost after interacting
@@ -209,8 +197,7 @@ void EMPairProduction::performInteraction(Candidate *candidate) const {
 	double s = lo + random.rand() * (hi - lo);
 
 	// sample electron / positron energy
-	static PPSecondariesEnergyDistribution interpolation;
-	double Ee = interpolation.sample(E, s);
+	double Ee = ppSecondariesEnergyDistribution().sample(E, s);
 	double Ep = E - Ee;
 	double f = Ep / E;
 
@@ -271,11 +258,11 @@ void EMPairProduction::process(Candidate *candidate) const {
 }
 
 void EMPairProduction::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string EMPairProduction::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 } // namespace crpropa
@@ -1,6 +1,7 @@
 #include "crpropa/module/EMTripletPairProduction.h"
 #include "crpropa/Units.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 
 #include <fstream>
 #include <limits>
@@ -38,67 +39,44 @@ void EMTripletPairProduction::setThinning(double thinning) {
 }
 
 void EMTripletPairProduction::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error("EMTripletPairProduction: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded interaction rates
 	tabEnergy.clear();
 	tabRate.clear();
 
-	while (infile.good()) {
-		if (infile.peek() != '#') {
-			double a, b;
-			infile >> a >> b;
-			if (infile) {
-				tabEnergy.push_back(pow(10, a) * eV);
-				tabRate.push_back(b / Mpc);
-			}
-		}
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 2);
+		tabEnergy.push_back(pow(10, row[0]) * eV);
+		tabRate.push_back(row[1] / Mpc);
 	}
-	infile.close();
 }
 
 void EMTripletPairProduction::initCumulativeRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error(
-				"EMTripletPairProduction: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded tables
 	tabE.clear();
 	tabs.clear();
 	tabCDF.clear();
-	
-	// skip header
-	while (infile.peek() == '#')
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
-
-	// read s values in first line
-	double a;
-	infile >> a; // skip first value
-	while (infile.good() and (infile.peek() != '\n')) {
-		infile >> a;
-		tabs.push_back(pow(10, a) * eV * eV);
-	}
 
-	// read all following lines: E, cdf values
-	while (infile.good()) {
-		infile >> a;
-		if (!infile)
-			break;  // end of file
-		tabE.push_back(pow(10, a) * eV);
-		std::vector<double> cdf;
-		for (int i = 0; i < tabs.size(); i++) {
-			infile >> a;
-			cdf.push_back(a / Mpc);
-		}
+	if (table->rows() == 0)
+		return;
+
+	// s values in first row, skip first value
+	const double *row = table->row(0);
+	for (size_t j = 1; j < table->rowSize(0); j++)
+		tabs.push_back(pow(10, row[j]) * eV * eV);
+
+	// all following rows: E, cdf values
+	for (size_t i = 1; i < table->rows(); i++) {
+		row = table->row(i, tabs.size() + 1);
+		tabE.push_back(pow(10, row[0]) * eV);
+		std::vector<double> cdf(tabs.size());
+		for (size_t j = 0; j < tabs.size(); j++)
+			cdf[j] = row[j + 1] / Mpc;
 		tabCDF.push_back(cdf);
 	}
-	infile.close();
 }
 
 void EMTripletPairProduction::performInteraction(Candidate *candidate) const {
@@ -177,11 +155,11 @@ void EMTripletPairProduction::process(Candidate *candidate) const {
 }
 
 void EMTripletPairProduction::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string EMTripletPairProduction::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 } // namespace crpropa
@@ -3,6 +3,7 @@
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 
 #include <cmath>
 #include <limits>
@@ -32,51 +33,23 @@ void ElasticScattering::setPhotonField(ref_ptr<PhotonField> photonField) {
 }
 
 void ElasticScattering::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (not infile.good())
-		throw std::runtime_error("ElasticScattering: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	tabRate.clear();
-
-	while (infile.good()) {
-		if (infile.peek() == '#') {
-			infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-			continue;
-		}
-		double r;
-		infile >> r;
-		if (!infile)
-			break;
-		tabRate.push_back(r / Mpc);
-	}
-
-	infile.close();
+	const double *r = table->data();
+	for (size_t i = 0; i < table->size(); i++)
+		tabRate.push_back(r[i] / Mpc);
 }
 
 void ElasticScattering::initCDF(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (not infile.good())
-		throw std::runtime_error("ElasticScattering: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	tabCDF.clear();
-	std::string line;
-	double a;
-	while (std::getline(infile, line)) {
-		if (line[0] == '#')
-			continue;
-
-		std::stringstream lineStream(line);
-		lineStream >> a;
-
-		std::vector<double> cdf(neps);
-		for (size_t i = 0; i < neps; i++) {
-			lineStream >> a;
-			cdf[i] = a;
-		}
-		tabCDF.push_back(cdf);
+	for (size_t i = 0; i < table->rows(); i++) {
+		// skip first value
+		const double *row = table->row(i, neps + 1) + 1;
+		tabCDF.push_back(std::vector<double>(row, row + neps));
 	}
-
-	infile.close();
 }
 
 void ElasticScattering::process(Candidate *candidate) const {
@@ -126,11 +99,11 @@ void ElasticScattering::process(Candidate *candidate) const {
 }
 
 void ElasticScattering::setInteractionTag(std::string tag) {
-	this -> interactionTag = tag;
+	this -> interactionTag = Symbol(tag);
 }
 
 std::string ElasticScattering::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 } // namespace crpropa
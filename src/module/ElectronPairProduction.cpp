@@ -3,6 +3,7 @@
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 
 #include <fstream>
 #include <limits>
@@ -40,47 +41,35 @@ void ElectronPairProduction::setLimit(double limit) {
 }
 
 void ElectronPairProduction::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error("ElectronPairProduction: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded interaction rates
 	tabLorentzFactor.clear();
 	tabLossRate.clear();
 
-	while (infile.good()) {
-		if (infile.peek() != '#') {
-			double a, b;
-			infile >> a >> b;
-			if (infile) {
-				tabLorentzFactor.push_back(pow(10, a));
-				tabLossRate.push_back(b / Mpc);
-			}
-		}
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 2);
+		tabLorentzFactor.push_back(pow(10, row[0]));
+		tabLossRate.push_back(row[1] / Mpc);
 	}
-	infile.close();
 }
 
 void ElectronPairProduction::initSpectrum(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (!infile.good())
-		throw std::runtime_error("ElectronPairProduction: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
+	if (table->size() < 70 * 170)
+		throw std::runtime_error("ElectronPairProduction: incomplete spectrum in " + filename);
 
-	double dNdE;
+	const double *dNdE = table->data();
 	tabSpectrum.resize(70);
 	for (size_t i = 0; i < 70; i++) {
 		tabSpectrum[i].resize(170);
 		for (size_t j = 0; j < 170; j++) {
-			infile >> dNdE;
-			tabSpectrum[i][j] = dNdE * pow(10, (7 + 0.1 * j)); // read electron distribution pdf(Ee) ~ dN/dEe * Ee
+			tabSpectrum[i][j] = dNdE[i * 170 + j] * pow(10, (7 + 0.1 * j)); // read electron distribution pdf(Ee) ~ dN/dEe * Ee
 		}
 		for (size_t j = 1; j < 170; j++) {
 			tabSpectrum[i][j] += tabSpectrum[i][j - 1]; // cdf(Ee), unnormalized
 		}
 	}
-	infile.close();
 }
 
 double ElectronPairProduction::lossLength(int id, double lf, double z) const {
@@ -146,11 +135,11 @@ void ElectronPairProduction::process(Candidate *c) const {
 }
 
 void ElectronPairProduction::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string ElectronPairProduction::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 
@@ -13,6 +13,13 @@ const hsize_t BUFFER_SIZE = 1024 * 16;
 
 namespace crpropa {
 
+// The serial libhdf5 is not thread-safe. All HDF5 calls of all HDF5Output
+// instances, including those of the asynchronous writer threads, take this lock.
+static std::recursive_mutex &hdf5Mutex() {
+	static std::recursive_mutex mutex;
+	return mutex;
+}
+
 // map variant types to H5T_NATIVE
 hid_t variantTypeToH5T_NATIVE(Variant::Type type) {
 	if (type == Variant::TYPE_INT64)
@@ -48,13 +55,13 @@ hid_t variantTypeToH5T_NATIVE(Variant::Type type) {
 	}
 }
 
-HDF5Output::HDF5Output() :  Output(), filename(), file(-1), sid(-1), dset(-1), dataspace(-1), candidatesSinceFlush(0), flushLimit(std::numeric_limits<unsigned int>::max()) {
+HDF5Output::HDF5Output() :  Output(), filename(), file(-1), sid(-1), dset(-1), dataspace(-1), candidatesSinceFlush(0), flushLimit(std::numeric_limits<unsigned int>::max()), asyncWrite(false), stopWriter(false) {
 }
 
-HDF5Output::HDF5Output(const std::string& filename) :  Output(), filename(filename), file(-1), sid(-1), dset(-1), dataspace(-1), candidatesSinceFlush(0), flushLimit(std::numeric_limits<unsigned int>::max()) {
+HDF5Output::HDF5Output(const std::string& filename) :  Output(), filename(filename), file(-1), sid(-1), dset(-1), dataspace(-1), candidatesSinceFlush(0), flushLimit(std::numeric_limits<unsigned int>::max()), asyncWrite(false), stopWriter(false) {
 }
 
-HDF5Output::HDF5Output(const std::string& filename, OutputType outputtype) :  Output(outputtype), filename(filename), file(-1), sid(-1), dset(-1), dataspace(-1), candidatesSinceFlush(0), flushLimit(std::numeric_limits<unsigned int>::max()) {
+HDF5Output::HDF5Output(const std::string& filename, OutputType outputtype) :  Output(outputtype), filename(filename), file(-1), sid(-1), dset(-1), dataspace(-1), candidatesSinceFlush(0), flushLimit(std::numeric_limits<unsigned int>::max()), asyncWrite(false), stopWriter(false) {
 	outputtype = outputtype;
 }
 
@@ -63,6 +70,7 @@ HDF5Output::~HDF5Output() {
 }
 
 herr_t HDF5Output::insertStringAttribute(const std::string &key, const std::string &value){
+	std::lock_guard<std::recursive_mutex> hdf5Lock(hdf5Mutex());
 	hid_t   strtype, attr_space, version_attr;
 	hsize_t dims = 0;
 	herr_t  status;
@@ -80,6 +88,7 @@ herr_t HDF5Output::insertStringAttribute(const std::string &key, const std::stri
 }
 
 herr_t HDF5Output::insertDoubleAttribute(const std::string &key, const double &value){
+	std::lock_guard<std::recursive_mutex> hdf5Lock(hdf5Mutex());
 	hid_t   type, attr_space, version_attr;
 	hsize_t dims = 0;
 	herr_t  status;
@@ -98,6 +107,7 @@ herr_t HDF5Output::insertDoubleAttribute(const std::string &key, const double &v
 
 
 void HDF5Output::open(const std::string& filename) {
+	std::lock_guard<std::recursive_mutex> hdf5Lock(hdf5Mutex());
 	file = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
 	if (file < 0)
 		throw std::runtime_error(std::string("Cannot create file: ") + filename);
@@ -208,6 +218,7 @@ void HDF5Output::open(const std::string& filename) {
 	insertDoubleAttribute("LengthScale", this->lengthScale);
 	insertDoubleAttribute("TimeScale", this->timeScale);
 	insertDoubleAttribute("EnergyScale", this->energyScale);
+	insertDoubleAttribute("SerialNumberBlockSize", Candidate::getSerialNumberBlockSize());
 
 	// add ranom seeds
 	std::vector< std::vector<uint32_t> > seeds = Random::getSeedThreads();
@@ -237,11 +248,32 @@ void HDF5Output::open(const std::string& filename) {
 
 	buffer.reserve(BUFFER_SIZE);
 	time(&lastFlush);
+
+	if (asyncWrite) {
+		writeBuffer.reserve(BUFFER_SIZE);
+		stopWriter = false;
+		writerThread = std::thread(&HDF5Output::writerLoop, this);
+	}
 }
 
 void HDF5Output::close() {
 	if (file >= 0) {
+		for (size_t i = 0; i < threadBuffer.size(); i++) {
+			if (threadBuffer[i].data.empty())
+				continue;
+			appendRows(threadBuffer[i].data);
+			threadBuffer[i].clear();
+		}
 		flush();
+		if (writerThread.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(writerMutex);
+				stopWriter = true;
+			}
+			writerCondition.notify_all();
+			writerThread.join();
+		}
+		std::lock_guard<std::recursive_mutex> hdf5Lock(hdf5Mutex());
 		H5Dclose(dset);
 		H5Tclose(sid);
 		H5Sclose(dataspace);
@@ -309,9 +341,9 @@ void HDF5Output::process(Candidate* candidate) const {
 			iter != properties.end(); ++iter)
 	{
 		  Variant v;
-			if (candidate->hasProperty((*iter).name))
+			if (candidate->hasProperty((*iter).symbol))
 			{
-				v = candidate->getProperty((*iter).name);
+				v = candidate->getProperty((*iter).symbol);
 			}
 			else
 			{
@@ -320,6 +352,19 @@ void HDF5Output::process(Candidate* candidate) const {
 			pos += v.copyToBuffer(&r.propertyBuffer[pos]);
 	}
 
+	if (useThreadBuffer()) {
+		ThreadBuffer<OutputRow>::Chunk &chunk = threadBuffer.local();
+		chunk.data.push_back(r);
+		if (chunk.data.size() >= threadBufferSize) {
+			#pragma omp critical(HDFOutput)
+			{
+				appendRows(chunk.data);
+			}
+			chunk.clear();
+		}
+		return;
+	}
+
 	#pragma omp critical(HDFOutput)
 	{
 		const_cast<HDF5Output*>(this)->candidatesSinceFlush++;
@@ -346,15 +391,74 @@ void HDF5Output::process(Candidate* candidate) const {
 	}
 }
 
+void HDF5Output::appendRows(const std::vector<OutputRow> &rows) const {
+	const_cast<HDF5Output*>(this)->candidatesSinceFlush += rows.size();
+	count += rows.size();
+
+	for (size_t i = 0; i < rows.size(); i++) {
+		buffer.push_back(rows[i]);
+		if (buffer.size() >= buffer.capacity())
+		{
+			KISS_LOG_DEBUG << "HDF5Output: Flush due to buffer capacity exceeded";
+			flush();
+		}
+	}
+
+	if (candidatesSinceFlush >= flushLimit)
+	{
+		KISS_LOG_DEBUG << "HDF5Output: Flush due to number of candidates";
+		flush();
+	}
+	else if (difftime(time(NULL), lastFlush) > 60*10)
+	{
+		KISS_LOG_DEBUG << "HDF5Output: Flush due to time exceeded";
+		flush();
+	}
+}
+
 void HDF5Output::flush() const {
 	const_cast<HDF5Output*>(this)->lastFlush = time(NULL);
 	const_cast<HDF5Output*>(this)->candidatesSinceFlush = 0;
 
-	hsize_t n = buffer.size();
+	if (writerThread.joinable()) {
+		// wait until the writer has finished the previous buffer and hand
+		// over the current one
+		std::unique_lock<std::mutex> lock(writerMutex);
+		writerCondition.wait(lock, [this] { return writeBuffer.empty(); });
+		buffer.swap(writeBuffer);
+		lock.unlock();
+		writerCondition.notify_all();
+		return;
+	}
+
+	writeRows(buffer);
+	buffer.clear();
+}
+
+void HDF5Output::writerLoop() {
+	std::unique_lock<std::mutex> lock(writerMutex);
+	while (true) {
+		writerCondition.wait(lock, [this] { return stopWriter || !writeBuffer.empty(); });
+		if (writeBuffer.empty())
+			break;
+
+		// the processing threads only touch writeBuffer when it is empty
+		lock.unlock();
+		writeRows(writeBuffer);
+		lock.lock();
+
+		writeBuffer.clear();
+		writerCondition.notify_all();
+	}
+}
+
+void HDF5Output::writeRows(const std::vector<OutputRow> &rows) const {
+	hsize_t n = rows.size();
 
 	if (n == 0)
 		return;
 
+	std::lock_guard<std::recursive_mutex> hdf5Lock(hdf5Mutex());
 	hid_t file_space = H5Dget_space(dset);
 	hsize_t count = H5Sget_simple_extent_npoints(file_space);
 
@@ -372,13 +476,11 @@ void HDF5Output::flush() const {
 	H5Sselect_hyperslab(file_space, H5S_SELECT_SET, offset, NULL, cnt, NULL);
 	hid_t mspace_id = H5Screate_simple(RANK, cnt, NULL);
 
-	H5Dwrite(dset, sid, mspace_id, file_space, H5P_DEFAULT, buffer.data());
+	H5Dwrite(dset, sid, mspace_id, file_space, H5P_DEFAULT, rows.data());
 
 	H5Sclose(mspace_id);
 	H5Sclose(file_space);
 
-	buffer.clear();
-
 	H5Fflush(file, H5F_SCOPE_GLOBAL);
 }
 
@@ -391,6 +493,16 @@ void HDF5Output::setFlushLimit(unsigned int N)
 	flushLimit = N;
 }
 
+void HDF5Output::setAsyncWrite(bool async) {
+	if (file >= 0)
+		throw std::runtime_error("HDF5Output: cannot change write mode after the file has been opened.");
+	asyncWrite = async;
+}
+
+bool HDF5Output::isAsyncWrite() const {
+	return asyncWrite;
+}
+
 } // namespace crpropa
 
 #endif // CRPROPA_HAVE_HDF5
@@ -3,6 +3,7 @@
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 
 #include <fstream>
 #include <limits>
@@ -21,35 +22,23 @@ NuclearDecay::NuclearDecay(bool electrons, bool photons, bool neutrinos, double
 	setDescription("NuclearDecay");
 
 	// load decay table
-	std::string filename = getDataPath("nuclear_decay.txt");
-	std::ifstream infile(filename.c_str());
-	if (!infile.good())
-		throw std::runtime_error(
-				"crpropa::NuclearDecay: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(getDataPath("nuclear_decay.txt"));
 
 	decayTable.resize(27 * 31);
-	std::string line;
-	while (std::getline(infile,line)) {
-		std::stringstream stream(line);
-		if (stream.peek() == '#')
-			continue;
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 4);
 		DecayMode decay;
-		int Z, N;
-		double lifetime;
-		stream >> Z >> N >> decay.channel >> lifetime;
+		int Z = row[0];
+		int N = row[1];
+		decay.channel = row[2];
+		double lifetime = row[3];
 		decay.rate = 1. / lifetime / c_light; // decay rate in [1/m]
-		std::vector<double> gamma;
-		double val;
-		while (stream >> val)
-			gamma.push_back(val);
-		for (int i = 0; i < gamma.size(); i += 2) {
-			decay.energy.push_back(gamma[i] * keV);
-			decay.intensity.push_back(gamma[i+1]);
+		for (size_t j = 4; j + 1 < table->rowSize(i); j += 2) {
+			decay.energy.push_back(row[j] * keV);
+			decay.intensity.push_back(row[j + 1]);
 		}
-		if (infile)
-			decayTable[Z * 31 + N].push_back(decay);
+		decayTable[Z * 31 + N].push_back(decay);
 	}
-	infile.close();
 }
 
 void NuclearDecay::setHaveElectrons(bool b) {
@@ -309,11 +298,11 @@ double NuclearDecay::meanFreePath(int id, double gamma) {
 }
 
 void NuclearDecay::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string NuclearDecay::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 } // namespace crpropa
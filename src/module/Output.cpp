@@ -3,13 +3,19 @@
 
 #include <stdexcept>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace crpropa {
 
-Output::Output() : outputName(OutputTypeName(Everything)), lengthScale(Mpc), timeScale(Myr), energyScale(EeV), oneDimensional(false), count(0) {
+const size_t Output::maxThreads;
+
+Output::Output() : outputName(OutputTypeName(Everything)), lengthScale(Mpc), timeScale(Myr), energyScale(EeV), oneDimensional(false), count(0), threadBufferSize(0) {
 	enableAll();
 }
 
-Output::Output(OutputType outputType) : outputName(OutputTypeName(outputType)), lengthScale(Mpc), timeScale(Myr), energyScale(EeV), oneDimensional(false), count(0) {
+Output::Output(OutputType outputType) : outputName(OutputTypeName(outputType)), lengthScale(Mpc), timeScale(Myr), energyScale(EeV), oneDimensional(false), count(0), threadBufferSize(0) {
 	setOutputType(outputType);
 }
 
@@ -139,10 +145,42 @@ size_t Output::size() const {
 	return count;
 }
 
+void Output::setThreadBufferSize(size_t rows) {
+	modify();
+	threadBufferSize = rows;
+}
+
+size_t Output::getThreadBufferSize() const {
+	return threadBufferSize;
+}
+
+bool Output::useThreadBuffer() const {
+	if (threadBufferSize <= 1)
+		return false;
+#ifdef _OPENMP
+	// outside of a parallel region all threads have the index 0
+	return omp_in_parallel();
+#else
+	return false;
+#endif
+}
+
+size_t Output::getThreadIndex() {
+#ifdef _OPENMP
+	size_t i = omp_get_thread_num();
+	if (i >= maxThreads)
+		throw std::runtime_error("crpropa::Output: more than maxThreads threads!");
+	return i;
+#else
+	return 0;
+#endif
+}
+
 void Output::enableProperty(const std::string &property, const Variant &defaultValue, const std::string &comment) {
 	modify();
 	Property prop;
 	prop.name = property;
+	prop.symbol = Symbol(property);
 	prop.comment = comment;
 	prop.defaultValue = defaultValue;
 	properties.push_back(prop);
@@ -46,7 +46,7 @@ void ShellPropertyOutput::process(Candidate* c) const {
 #pragma omp critical(ShellOutput)
 	{
 		for ( ; i != c->properties.end(); i++) {
-			std::cout << "  " << i->first << ", " << i->second << std::endl;
+			std::cout << "  " << i->first.str() << ", " << i->second << std::endl;
 		}
 	}
 }
@@ -3,6 +3,7 @@
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 #include "kiss/logger.h"
 
 #include <cmath>
@@ -41,108 +42,62 @@ void PhotoDisintegration::setLimit(double limit) {
 }
 
 void PhotoDisintegration::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (not infile.good())
-		throw std::runtime_error("PhotoDisintegration: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded interaction rates
 	pdRate.clear();
 	pdRate.resize(27 * 31);
 
-	std::string line;
-	while (std::getline(infile, line)) {
-		if (line[0] == '#')
-			continue;
-		std::stringstream lineStream(line);
-
-		int Z, N;
-		lineStream >> Z;
-		lineStream >> N;
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 2 + nlg);
+		int Z = row[0];
+		int N = row[1];
 
-		double r;
-		for (size_t i = 0; i < nlg; i++) {
-			lineStream >> r;
-			pdRate[Z * 31 + N].push_back(r / Mpc);
-		}
+		for (size_t j = 0; j < nlg; j++)
+			pdRate[Z * 31 + N].push_back(row[j + 2] / Mpc);
 	}
-	infile.close();
 }
 
 void PhotoDisintegration::initBranching(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (not infile.good())
-		throw std::runtime_error("PhotoDisintegration: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded interaction rates
 	pdBranch.clear();
 	pdBranch.resize(27 * 31);
 
-	std::string line;
-	while (std::getline(infile, line)) {
-		if (line[0] == '#')
-			continue;
-
-		std::stringstream lineStream(line);
-
-		int Z, N;
-		lineStream >> Z;
-		lineStream >> N;
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 3 + nlg);
+		int Z = row[0];
+		int N = row[1];
 
 		Branch branch;
-		lineStream >> branch.channel;
-
-		double r;
-		for (size_t i = 0; i < nlg; i++) {
-			lineStream >> r;
-			branch.branchingRatio.push_back(r);
-		}
+		branch.channel = row[2];
+		branch.branchingRatio.assign(row + 3, row + 3 + nlg);
 
 		pdBranch[Z * 31 + N].push_back(branch);
 	}
-
-	infile.close();
 }
 
 void PhotoDisintegration::initPhotonEmission(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (not infile.good())
-		throw std::runtime_error("PhotoDisintegration: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	// clear previously loaded emission probabilities
 	pdPhoton.clear();
 
-	std::string line;
-	while (std::getline(infile, line)) {
-		if (line[0] == '#')
-			continue;
-
-		std::stringstream lineStream(line);
-
-		int Z, N, Zd, Nd;
-		lineStream >> Z;
-		lineStream >> N;
-		lineStream >> Zd;
-		lineStream >> Nd;
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 5 + nlg);
+		int Z = row[0];
+		int N = row[1];
+		int Zd = row[2];
+		int Nd = row[3];
 
 		PhotonEmission em;
-		lineStream >> em.energy;
-		em.energy *= eV;
-
-		double r;
-		for (size_t i = 0; i < nlg; i++) {
-			lineStream >> r;
-			em.emissionProbability.push_back(r);
-		}
+		em.energy = row[4] * eV;
+		em.emissionProbability.assign(row + 5, row + 5 + nlg);
 
 		int key = Z * 1000000 + N * 10000 + Zd * 100 + Nd;
-		if (pdPhoton.find(key) == pdPhoton.end()) {
-			std::vector<PhotonEmission> emissions;
-			pdPhoton[key] = emissions;
-		}
 		pdPhoton[key].push_back(em);
 	}
-
-	infile.close();
 }
 
 void PhotoDisintegration::process(Candidate *candidate) const {
@@ -320,11 +275,11 @@ double PhotoDisintegration::lossLength(int id, double gamma, double z) {
 }
 
 void PhotoDisintegration::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string PhotoDisintegration::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 } // namespace crpropa
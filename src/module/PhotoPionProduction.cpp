@@ -2,6 +2,7 @@
 #include "crpropa/Units.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 
 #include "kiss/convert.h"
 #include "kiss/logger.h"
@@ -78,21 +79,13 @@ void PhotoPionProduction::initRate(std::string filename) {
 	tabProtonRate.clear();
 	tabNeutronRate.clear();
 
-	std::ifstream infile(filename.c_str());
-	if (!infile.good())
-		throw std::runtime_error("PhotoPionProduction: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(filename);
 
 	if (haveRedshiftDependence) {
 		double zOld = -1, aOld = -1;
-		while (infile.good()) {
-			if (infile.peek() == '#') {
-				infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-				continue;
-			}
-			double z, a, b, c;
-			infile >> z >> a >> b >> c;
-			if (!infile)
-				break;
+		for (size_t i = 0; i < table->rows(); i++) {
+			const double *row = table->row(i, 4);
+			double z = row[0], a = row[1];
 			if (z > zOld) {
 				tabRedshifts.push_back(z);
 				zOld = z;
@@ -101,26 +94,17 @@ void PhotoPionProduction::initRate(std::string filename) {
 				tabLorentz.push_back(pow(10, a));
 				aOld = a;
 			}
-			tabProtonRate.push_back(b / Mpc);
-			tabNeutronRate.push_back(c / Mpc);
+			tabProtonRate.push_back(row[2] / Mpc);
+			tabNeutronRate.push_back(row[3] / Mpc);
 		}
 	} else {
-		while (infile.good()) {
-			if (infile.peek() == '#') {
-				infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-				continue;
-			}
-			double a, b, c;
-			infile >> a >> b >> c;
-			if (!infile)
-				break;
-			tabLorentz.push_back(pow(10, a));
-			tabProtonRate.push_back(b / Mpc);
-			tabNeutronRate.push_back(c / Mpc);
+		for (size_t i = 0; i < table->rows(); i++) {
+			const double *row = table->row(i, 3);
+			tabLorentz.push_back(pow(10, row[0]));
+			tabProtonRate.push_back(row[1] / Mpc);
+			tabNeutronRate.push_back(row[2] / Mpc);
 		}
 	}
-
-	infile.close();
 }
 
 double PhotoPionProduction::nucleonMFP(double gamma, double z, bool onProton) const {
@@ -672,11 +656,11 @@ double PhotoPionProduction::getCorrectionFactor() const {
 }
 
 void PhotoPionProduction::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string PhotoPionProduction::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 } // namespace crpropa
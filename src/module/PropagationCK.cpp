@@ -3,7 +3,6 @@
 #include <limits>
 #include <sstream>
 #include <stdexcept>
-#include <vector>
 
 namespace crpropa {
 
@@ -27,24 +26,32 @@ const double cash_karp_bs[] = {
 
 void PropagationCK::tryStep(const Y &y, Y &out, Y &error, double h,
 		ParticleState &particle, double z) const {
-	std::vector<Y> k;
-	k.reserve(6);
+	tryStep(y, dYdt(y, particle, z), out, error, h, particle, z);
+}
+
+void PropagationCK::tryStep(const Y &y, const Y &k0, Y &out, Y &error,
+		double h, ParticleState &particle, double z) const {
+	// stages are kept on the stack, the first one does not depend on the
+	// step size and is provided by the caller
+	Y k[6];
+	k[0] = k0;
 
 	out = y;
-	error = Y(0);
+	out += k[0] * cash_karp_b[0] * h;
+	error = k[0] * (cash_karp_b[0] - cash_karp_bs[0]) * h;
 
 	// calculate the sum of b_i * k_i
-	for (size_t i = 0; i < 6; i++) {
+	for (size_t i = 1; i < 6; i++) {
 
 		Y y_n = y;
 		for (size_t j = 0; j < i; j++)
-			y_n += k[j] * a[i * 6 + j] * h;
+			y_n += k[j] * cash_karp_a[i * 6 + j] * h;
 
 		// update k_i
 		k[i] = dYdt(y_n, particle, z);
 
-		out += k[i] * b[i] * h;
-		error += k[i] * (b[i] - bs[i]) * h;
+		out += k[i] * cash_karp_b[i] * h;
+		error += k[i] * (cash_karp_b[i] - cash_karp_bs[i]) * h;
 	}
 }
 
@@ -60,6 +67,12 @@ PropagationCK::Y PropagationCK::dYdt(const Y &y, ParticleState &p, double z) con
 	return Y(velocity, dudt);
 }
 
+PropagationCK::Y PropagationCK::dYdt(const Y &y, ParticleState &p, const Vector3d &B) const {
+	Vector3d velocity = y.u.getUnitVector() * c_light;
+	Vector3d dudt = p.getCharge() * c_light / p.getEnergy() * velocity.cross(B);
+	return Y(velocity, dudt);
+}
+
 PropagationCK::PropagationCK(ref_ptr<MagneticField> field, double tolerance,
 		double minStep, double maxStep) :
 		minStep(0) {
@@ -67,11 +80,6 @@ PropagationCK::PropagationCK(ref_ptr<MagneticField> field, double tolerance,
 	setTolerance(tolerance);
 	setMaximumStep(maxStep);
 	setMinimumStep(minStep);
-
-	// load Cash-Karp coefficients
-	a.assign(cash_karp_a, cash_karp_a + 36);
-	b.assign(cash_karp_b, cash_karp_b + 6);
-	bs.assign(cash_karp_bs, cash_karp_bs + 6);
 }
 
 void PropagationCK::process(Candidate *candidate) const {
@@ -95,11 +103,15 @@ void PropagationCK::process(Candidate *candidate) const {
 	double newStep = step;
 	double z = candidate->getRedshift();
 
+	// the first stage only depends on the initial phase point and is
+	// reused for all trial steps. The field at the initial position is taken
+	// from the candidate, which shares it with other modules in this step
+	Y k0 = dYdt(yIn, current, getFieldAtPosition(yIn.x, z, candidate));
 
 	// if minStep is the same as maxStep the adaptive algorithm with its error
 	// estimation is not needed and the computation time can be saved:
 	if (minStep == maxStep){
-		tryStep(yIn, yOut, yErr, step / c_light, current, z);
+		tryStep(yIn, k0, yOut, yErr, step / c_light, current, z);
 	} else {
 		step = clip(candidate->getNextStep(), minStep, maxStep);
 		newStep = step;
@@ -107,7 +119,7 @@ void PropagationCK::process(Candidate *candidate) const {
 
 		// try performing step until the target error (tolerance) or the minimum/maximum step size has been reached
 		while (true) {
-			tryStep(yIn, yOut, yErr, step / c_light, current, z);
+			tryStep(yIn, k0, yOut, yErr, step / c_light, current, z);
 			r = yErr.u.getR() / tolerance;  // ratio of absolute direction error and tolerance
 			if (r > 1) {  // large direction error relative to tolerance, try to decrease step size
 				if (step == minStep)  // already minimum step size
@@ -157,6 +169,18 @@ Vector3d PropagationCK::getFieldAtPosition(Vector3d pos, double z) const {
 	return B;
 }
 
+Vector3d PropagationCK::getFieldAtPosition(Vector3d pos, double z, Candidate *candidate) const {
+	Vector3d B(0, 0, 0);
+	try {
+		if (field.valid())
+			B = candidate->getMagneticField(field, pos, z);
+	} catch (std::exception &e) {
+		KISS_LOG_ERROR 	<< "PropagationCK: Exception in PropagationCK::getFieldAtPosition.\n"
+				<< e.what();
+	}
+	return B;
+}
+
 void PropagationCK::setTolerance(double tol) {
 	if ((tol > 1) or (tol < 0))
 		throw std::runtime_error(
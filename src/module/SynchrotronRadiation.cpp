@@ -1,6 +1,7 @@
 #include "crpropa/module/SynchrotronRadiation.h"
 #include "crpropa/Units.h"
 #include "crpropa/Random.h"
+#include "crpropa/DataTable.h"
 
 #include <fstream>
 #include <limits>
@@ -86,28 +87,17 @@ double SynchrotronRadiation::getSecondaryThreshold() const {
 }
 
 void SynchrotronRadiation::initSpectrum() {
-	std::string filename = getDataPath("Synchrotron/spectrum.txt");
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
-		throw std::runtime_error("SynchrotronRadiation: could not open file " + filename);
+	ref_ptr<DataTable> table = DataTable::load(getDataPath("Synchrotron/spectrum.txt"));
 
 	// clear previously loaded interaction rates
 	tabx.clear();
 	tabCDF.clear();
 
-	while (infile.good()) {
-		if (infile.peek() != '#') {
-			double a, b;
-			infile >> a >> b;
-			if (infile) {
-				tabx.push_back(pow(10, a));
-				tabCDF.push_back(b);
-			}
-		}
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
+	for (size_t i = 0; i < table->rows(); i++) {
+		const double *row = table->row(i, 2);
+		tabx.push_back(pow(10, row[0]));
+		tabCDF.push_back(row[1]);
 	}
-	infile.close();
 }
 
 void SynchrotronRadiation::process(Candidate *candidate) const {
@@ -119,7 +109,7 @@ void SynchrotronRadiation::process(Candidate *candidate) const {
 	double z = candidate->getRedshift();
 	double B;
 	if (field.valid()) {
-		Vector3d Bvec = field->getField(candidate->current.getPosition(), z);
+		Vector3d Bvec = candidate->getMagneticField(field, candidate->current.getPosition(), z);
 		B = Bvec.cross(candidate->current.getDirection()).getR();
 	} else {
 		B = sqrt(2. / 3) * Brms; // average perpendicular field component
@@ -222,11 +212,11 @@ std::string SynchrotronRadiation::getDescription() const {
 }
 
 void SynchrotronRadiation::setInteractionTag(std::string tag) {
-	interactionTag = tag;
+	interactionTag = Symbol(tag);
 }
 
 std::string SynchrotronRadiation::getInteractionTag() const {
-	return interactionTag;
+	return interactionTag.str();
 }
 
 } // namespace crpropa
@@ -115,8 +115,11 @@ void TextOutput::printHeader() const {
 				<< " Myr]\n";
 	if (fields.test(RedshiftColumn))
 		*out << "# z             Redshift\n";
-	if (fields.test(SerialNumberColumn))
+	if (fields.test(SerialNumberColumn)) {
 		*out << "# SN/SN0/SN1    Serial number. Unique (within this run) id of the particle.\n";
+		if (Candidate::getSerialNumberBlockSize() > 1)
+			*out << "#               Allocated in blocks of " << Candidate::getSerialNumberBlockSize() << " per thread.\n";
+	}
 	if (fields.test(CurrentIdColumn) || fields.test(CreatedIdColumn)
 			|| fields.test(SourceIdColumn))
 		*out << "# ID/ID0/ID1    Particle type (PDG MC numbering scheme)\n";
@@ -270,8 +273,8 @@ void TextOutput::process(Candidate *c) const {
 	for(std::vector<Output::Property>::const_iterator iter = properties.begin();
 			iter != properties.end(); ++iter) {
 		  Variant v;
-			if (c->hasProperty((*iter).name)) {
-				v = c->getProperty((*iter).name);
+			if (c->hasProperty((*iter).symbol)) {
+				v = c->getProperty((*iter).symbol);
 			} else {
 				v = (*iter).defaultValue;
 			}
@@ -282,14 +285,38 @@ void TextOutput::process(Candidate *c) const {
 
 	std::locale::global(old_locale);
 
+	if (useThreadBuffer()) {
+		ThreadBuffer<char>::Chunk &chunk = threadBuffer.local();
+		chunk.data.insert(chunk.data.end(), buffer, buffer + p);
+		chunk.rows++;
+		if (chunk.rows >= threadBufferSize) {
+			write(chunk.data.data(), chunk.data.size(), chunk.rows);
+			chunk.clear();
+		}
+		return;
+	}
+
+	write(buffer, p, 1);
+}
+
+void TextOutput::write(const char *data, size_t size, size_t rows) const {
 #pragma omp critical(FileOutput)
 	{
 		if (count == 0)
 			printHeader();
-		Output::process(c);
-		out->write(buffer, p);
+		count += rows;
+		out->write(data, size);
 	}
+}
 
+void TextOutput::flushThreadBuffers() {
+	for (size_t i = 0; i < threadBuffer.size(); i++) {
+		ThreadBuffer<char>::Chunk &chunk = threadBuffer[i];
+		if (chunk.rows == 0)
+			continue;
+		write(chunk.data.data(), chunk.data.size(), chunk.rows);
+		chunk.clear();
+	}
 }
 
 void TextOutput::load(const std::string &filename, ParticleCollector *collector){
@@ -370,6 +397,7 @@ std::string TextOutput::getDescription() const {
 }
 
 void TextOutput::close() {
+	flushThreadBuffers();
 #ifdef CRPROPA_HAVE_ZLIB
 	zstream::ogzstream *zs = dynamic_cast<zstream::ogzstream *>(out);
 	if (zs) {
@@ -6,10 +6,14 @@
  */
 
 #include <complex>
+#include <ctime>
+#include <fstream>
+#include <iostream>
 
 #include "crpropa/Candidate.h"
 #include "crpropa/base64.h"
 #include "crpropa/Common.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/Units.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
@@ -19,6 +23,7 @@
 #include "crpropa/Geometry.h"
 #include "crpropa/EmissionMap.h"
 #include "crpropa/Vector3.h"
+#include "crpropa/magneticField/MagneticField.h"
 
 #include <HepPID/ParticleIDMethods.hh>
 #include "gtest/gtest.h"
@@ -210,6 +215,26 @@ TEST(Candidate, property) {
 	EXPECT_TRUE(candidate.hasProperty("foo"));
 	std::string value = candidate.getProperty("foo");
 	EXPECT_EQ("bar", value);
+
+	// access by interned name
+	Symbol foo("foo");
+	EXPECT_TRUE(candidate.hasProperty(foo));
+	EXPECT_EQ("bar", candidate.getProperty(foo).toString());
+	EXPECT_TRUE(candidate.removeProperty(foo));
+	EXPECT_FALSE(candidate.hasProperty("foo"));
+}
+
+TEST(Symbol, intern) {
+	Symbol a("foo"), b(std::string("foo")), c("bar"), empty;
+	EXPECT_TRUE(a == b);
+	EXPECT_EQ(a.index(), b.index());
+	EXPECT_TRUE(a != c);
+	EXPECT_EQ(a.str(), "foo");
+	EXPECT_EQ(c.str(), "bar");
+	EXPECT_EQ(empty.str(), "");
+	EXPECT_EQ(empty.index(), 0);
+	EXPECT_TRUE(empty == Symbol(""));
+	EXPECT_TRUE(Symbol(a.str()) == a);
 }
 
 TEST(Candidate, weight) {
@@ -271,6 +296,28 @@ TEST(Candidate, candidateTag) {
 	// test setting tag
 	c.setTagOrigin("myTag");
 	EXPECT_TRUE(c.getTagOrigin() == "myTag");
+	EXPECT_TRUE(c.getTagSymbol() == Symbol("myTag"));
+
+	// tag and properties are passed to secondaries
+	c.setProperty("foo", 1);
+	c.addSecondary(22, 1 * EeV, 1., Symbol("SEC"));
+	EXPECT_TRUE(c.secondaries[0]->getTagOrigin() == "SEC");
+	EXPECT_TRUE(c.secondaries[0]->hasProperty("foo"));
+}
+
+TEST(Candidate, pool) {
+	// freed candidates are reused by the next allocation on the same thread
+	Candidate *c1 = new Candidate();
+	delete c1;
+	Candidate *c2 = new Candidate(nucleusId(1, 1), 1 * EeV);
+	EXPECT_EQ(c1, c2);
+	EXPECT_EQ(c2->current.getEnergy(), 1 * EeV);
+
+	ref_ptr<Candidate> c3 = new Candidate();
+	c3->addSecondary(nucleusId(1, 1), 1 * EeV);
+	EXPECT_NE(c2, c3.get());
+	EXPECT_NE(c2, c3->secondaries[0].get());
+	delete c2;
 }
 
 TEST(Candidate, serialNumber) {
@@ -279,6 +326,57 @@ TEST(Candidate, serialNumber) {
 	EXPECT_EQ(43, c.getSourceSerialNumber());
 }
 
+TEST(Candidate, serialNumberBlocks) {
+	Candidate::setSerialNumberBlockSize(10);
+	Candidate::setNextSerialNumber(100);
+	Candidate c1, c2;
+	EXPECT_EQ(101, c1.getSerialNumber());
+	EXPECT_EQ(102, c2.getSerialNumber());
+	// the whole block is reserved
+	EXPECT_EQ(110, Candidate::getNextSerialNumber());
+
+	for (int i = 0; i < 8; i++)
+		Candidate::allocateSerialNumber();
+	Candidate c3;
+	EXPECT_EQ(111, c3.getSerialNumber());
+	EXPECT_EQ(120, Candidate::getNextSerialNumber());
+
+	Candidate::setSerialNumberBlockSize(1);
+	Candidate c4;
+	EXPECT_EQ(121, c4.getSerialNumber());
+	EXPECT_EQ(121, Candidate::getNextSerialNumber());
+}
+
+class CountingField: public MagneticField {
+public:
+	mutable int calls;
+	CountingField() : calls(0) {
+	}
+	Vector3d getField(const Vector3d &position) const {
+		calls++;
+		return position;
+	}
+};
+
+TEST(Candidate, magneticFieldCache) {
+	Candidate c;
+	ref_ptr<CountingField> field = new CountingField();
+	ref_ptr<CountingField> other = new CountingField();
+
+	EXPECT_EQ(Vector3d(1, 2, 3), c.getMagneticField(field, Vector3d(1, 2, 3), 0));
+	EXPECT_EQ(Vector3d(1, 2, 3), c.getMagneticField(field, Vector3d(1, 2, 3), 0));
+	EXPECT_EQ(1, field->calls);
+
+	// different position, redshift or field
+	c.getMagneticField(field, Vector3d(1, 2, 4), 0);
+	EXPECT_EQ(2, field->calls);
+	c.getMagneticField(field, Vector3d(1, 2, 4), 0.1);
+	EXPECT_EQ(3, field->calls);
+	c.getMagneticField(other, Vector3d(1, 2, 4), 0.1);
+	EXPECT_EQ(3, field->calls);
+	EXPECT_EQ(1, other->calls);
+}
+
 TEST(common, digit) {
 	EXPECT_EQ(1, digit(1234, 1000));
 	EXPECT_EQ(2, digit(1234, 100));
@@ -442,6 +540,116 @@ TEST(Random, base64Seed) {
 	}
 }
 
+TEST(Random, randBinView) {
+	// sampling from a row of a table gives the same bins as from a copy of the row
+	std::vector<double> table(30);
+	for (size_t i = 0; i < table.size(); i++)
+		table[i] = (i % 10 + 1) * (i % 10 + 1);
+	std::vector<double> row(table.begin() + 10, table.begin() + 20);
+
+	Random a(42), b(42);
+	for (size_t i = 0; i < 100; i++)
+		EXPECT_EQ(a.randBin(row), b.randBin(&table[10], 10));
+}
+
+TEST(Random, counterBasedStreams) {
+	Random a, b;
+
+	// Philox4x32-10 known answer for zero key and counter
+	Random::enableStreams(0);
+	a.setStream(0, 0);
+	EXPECT_EQ(a.randInt(), 0x6627e8d5);
+	EXPECT_EQ(a.randInt(), 0xe169c58d);
+	EXPECT_EQ(a.randInt(), 0xbc57ac4c);
+	EXPECT_EQ(a.randInt(), 0x9b00dbd8);
+
+	// same seed, stream and step give the same numbers
+	Random::enableStreams(42);
+	a.setStream(123, 7);
+	b.setStream(123, 7);
+	for (size_t i = 0; i < 42; i++)
+		EXPECT_EQ(a.rand(), b.rand());
+
+	// different step or stream give different numbers
+	a.setStream(123, 7);
+	b.setStream(123, 8);
+	EXPECT_NE(a.randInt(), b.randInt());
+	a.setStream(123, 7);
+	b.setStream(Random::deriveStream(123, 0), 7);
+	EXPECT_NE(a.randInt(), b.randInt());
+
+	// seeding switches back to the Mersenne Twister
+	a.seed(42);
+	b.seed(42);
+	b.setStream(123, 7);
+	b.seed(42);
+	EXPECT_EQ(a.randInt(), b.randInt());
+
+	Random::disableStreams();
+	EXPECT_FALSE(Random::haveStreams());
+}
+
+TEST(DataTable, textAndBinary) {
+	std::string txt = "DataTable_test.txt";
+	std::string bin = DataTable::binaryFilename(txt);
+	EXPECT_EQ(bin, "DataTable_test.bin");
+
+	std::ofstream out(txt.c_str());
+	out << "# header\n1 2.5 -3e2\n\n4 5\n# comment\n6\n";
+	out.close();
+
+	ref_ptr<DataTable> table = DataTable::load(txt);
+	EXPECT_FALSE(table->isMapped());
+	EXPECT_EQ(table->rows(), 3);
+	EXPECT_EQ(table->size(), 6);
+	EXPECT_EQ(table->rowSize(0), 3);
+	EXPECT_EQ(table->rowSize(1), 2);
+	EXPECT_DOUBLE_EQ(table->get(0, 2), -300);
+	EXPECT_DOUBLE_EQ(table->row(2)[0], 6);
+	EXPECT_DOUBLE_EQ(table->row(1, 2)[1], 5);
+#ifndef CRPROPA_TESTS_SKIP_EXCEPTIONS
+	// short rows are reported with the line in the text file
+	try {
+		table->row(2, 2);
+		FAIL() << "short row not detected";
+	} catch (std::runtime_error &e) {
+		EXPECT_EQ(std::string(e.what()), "crpropa::DataTable: DataTable_test.txt line 6: expected 2 values, found 1");
+	}
+#endif
+	// text tables are not cached
+	EXPECT_NE(DataTable::load(txt).get(), table.get());
+
+	table->saveBinary(bin);
+	DataTable::clearCache();
+
+	ref_ptr<DataTable> mapped = DataTable::load(txt);
+	EXPECT_TRUE(mapped->isMapped());
+	EXPECT_EQ(mapped->rows(), table->rows());
+	for (size_t i = 0; i < table->size(); i++)
+		EXPECT_EQ(mapped->data()[i], table->data()[i]);
+	// loading again returns the cached table
+	EXPECT_EQ(DataTable::load(txt).get(), mapped.get());
+#ifndef CRPROPA_TESTS_SKIP_EXCEPTIONS
+	EXPECT_THROW(mapped->row(2, 2), std::runtime_error);
+#endif
+
+	// a binary file with decreasing offsets is ignored in favour of the text file
+	DataTable::clearCache();
+	mapped = 0;
+	std::fstream corrupt(bin.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+	corrupt.seekp(32 + 2 * sizeof(uint64_t));
+	uint64_t offset = 1;
+	corrupt.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+	corrupt.close();
+	ref_ptr<DataTable> fallback = DataTable::load(txt);
+	EXPECT_FALSE(fallback->isMapped());
+	EXPECT_EQ(fallback->rowSize(1), 2);
+
+	DataTable::clearCache();
+	std::remove(txt.c_str());
+	std::remove(bin.c_str());
+}
+
 TEST(Grid, PeriodicClamp) {
 	// Test correct determination of lower and upper neighbor
 	int lo, hi;
@@ -679,7 +887,7 @@ TEST(Grid3f, Interpolation) {
 	EXPECT_FLOAT_EQ(1.7 * 0.9 * 0.15, b.x);
 	
 	//tricubic
-	#ifdef HAVE_SIMD
+	#ifdef CRPROPA_HAVE_SSE
 	grid.setInterpolationType(TRICUBIC);
 	
 	b = grid.interpolate(Vector3d(0.5, 0.5, 1.5) * spacing);
@@ -696,7 +904,7 @@ TEST(Grid3f, Interpolation) {
 
 	b = grid.interpolate(Vector3d(0.5, 2.65, 1.6) * spacing);
 	EXPECT_FLOAT_EQ(0.190802007914, b.x);
-	#endif // HAVE_SIMD
+	#endif // CRPROPA_HAVE_SSE
 }
 
 TEST(VectordGrid, Scale) {
@@ -745,7 +953,7 @@ TEST(Grid3f, Periodicity) {
 	EXPECT_FLOAT_EQ(b.z, b2.z);
 	
 	//tricubic interpolated
-	#ifdef HAVE_SIMD
+	#ifdef CRPROPA_HAVE_SSE
 	grid.setInterpolationType(TRICUBIC);
 	b = grid.interpolate(pos);
 	b2 = grid.interpolate(pos + Vector3d(1, 0, 0) * size);
@@ -762,7 +970,7 @@ TEST(Grid3f, Periodicity) {
 	EXPECT_FLOAT_EQ(b.x, b2.x);
 	EXPECT_FLOAT_EQ(b.y, b2.y);
 	EXPECT_FLOAT_EQ(b.z, b2.z);
-	#endif // HAVE_SIMD
+	#endif // CRPROPA_HAVE_SSE
 	
 	//nearest neighbour interpolated
 	grid.setInterpolationType(NEAREST_NEIGHBOUR);
@@ -824,7 +1032,7 @@ TEST(Grid3f, Reflectivity) {
 	EXPECT_FLOAT_EQ(b.z, b2.z);
 	
 	//tricubic interpolated
-	#ifdef HAVE_SIMD
+	#ifdef CRPROPA_HAVE_SSE
 	grid.setInterpolationType(TRICUBIC);
 	b = grid.interpolate(pos + Vector3d(1,0,0) * spacing);
 	b2 = grid.interpolate(pos *(-1) - Vector3d(1,0,0) * spacing);
@@ -843,7 +1051,7 @@ TEST(Grid3f, Reflectivity) {
 	EXPECT_FLOAT_EQ(b.x, b2.x);
 	EXPECT_FLOAT_EQ(b.y, b2.y);
 	EXPECT_FLOAT_EQ(b.z, b2.z);
-	#endif //HAVE_SIMD
+	#endif // CRPROPA_HAVE_SSE
 	
 	//nearest neighbour interpolated
 	grid.setInterpolationType(NEAREST_NEIGHBOUR);
@@ -1036,6 +1244,185 @@ TEST(Grid3f, DumpLoadTxtGridProperties) {
 	}
 }
 
+TEST(Grid3f, DumpMapBinary) {
+	ref_ptr<Grid3f> grid = new Grid3f(Vector3d(0.5, 1.5, 2.5), 3, 2, 4, Vector3d(0.2, 1.2, 2.2));
+	grid->setInterpolationType(NEAREST_NEIGHBOUR);
+	grid->setReflective(true);
+	for (int ix = 0; ix < grid->getNx(); ix++)
+		for (int iy = 0; iy < grid->getNy(); iy++)
+			for (int iz = 0; iz < grid->getNz(); iz++)
+				grid->get(ix, iy, iz) = Vector3f(-iy, ix, 2 * iz);
+
+	dumpGridBinary(grid, "testDump.grid");
+	ref_ptr<Grid3f> mapped = mapGrid3f("testDump.grid");
+
+	EXPECT_TRUE(mapped->isMapped());
+	EXPECT_FALSE(grid->isMapped());
+	EXPECT_EQ(4, mapped->getNz());
+	EXPECT_EQ(grid->getOrigin(), mapped->getOrigin());
+	EXPECT_EQ(grid->getSpacing(), mapped->getSpacing());
+	EXPECT_EQ(NEAREST_NEIGHBOUR, mapped->getInterpolationType());
+	EXPECT_TRUE(mapped->isReflective());
+	EXPECT_FALSE(mapped->getClipVolume());
+	for (int ix = 0; ix < grid->getNx(); ix++)
+		for (int iy = 0; iy < grid->getNy(); iy++)
+			for (int iz = 0; iz < grid->getNz(); iz++)
+				EXPECT_EQ(grid->get(ix, iy, iz), mapped->getValue(ix, iy, iz));
+
+	// the mapping is read-only
+	EXPECT_THROW(mapped->get(1, 1, 1), std::runtime_error);
+	EXPECT_THROW(mapped->setValue(1, 1, 1, Vector3f(42.)), std::runtime_error);
+	const Grid3f &constMapped = *mapped;
+	EXPECT_EQ(Vector3f(-1, 1, 2), constMapped.get(1, 1, 1));
+
+	// a Grid1f file can not be mapped as Grid3f
+	dumpGridBinary(new Grid1f(Vector3d(0.), 2, 1), "testDump.grid");
+	EXPECT_EQ(2, mapGrid1f("testDump.grid")->getNx());
+	EXPECT_THROW(mapGrid3f("testDump.grid"), std::runtime_error);
+	std::remove("testDump.grid");
+}
+
+TEST(Grid, halfPrecision) {
+	EXPECT_EQ(0x3c00, floatToHalf(1.f));
+	EXPECT_EQ(0xc000, floatToHalf(-2.f));
+	EXPECT_EQ(0x7bff, floatToHalf(65504.f));
+	EXPECT_EQ(0x7c00, floatToHalf(1e6f));
+	EXPECT_EQ(0x0001, floatToHalf(std::ldexp(1.f, -24)));
+	EXPECT_EQ(0x3555, floatToHalf(1.f / 3));
+	// all finite half precision numbers are converted exactly
+	for (uint32_t h = 0; h < 0x10000; h++) {
+		if ((h & 0x7c00) == 0x7c00)
+			continue;
+		EXPECT_EQ(h, floatToHalf(halfToFloat(h)));
+	}
+
+	EXPECT_EQ(0x3f80, floatToBFloat16(1.f));
+	EXPECT_FLOAT_EQ(3.140625, bfloat16ToFloat(floatToBFloat16(3.14159f)));
+	EXPECT_NEAR(1e-12, bfloat16ToFloat(floatToBFloat16(1e-12f)), 1e-12 / 256);
+}
+
+TEST(Grid3f, ReducedPrecision) {
+	ref_ptr<Grid3f> grid = new Grid3f(Vector3d(0.), 8, 1);
+	for (int ix = 0; ix < 8; ix++)
+		for (int iy = 0; iy < 8; iy++)
+			for (int iz = 0; iz < 8; iz++)
+				grid->get(ix, iy, iz) = Vector3f(sin(ix), cos(iy), iz - 4.) * 1e-10;
+
+	Grid3f reference(*grid);
+	Vector3d pos(2.3, 5.1, 0.7);
+	Vector3f b = reference.interpolate(pos);
+
+	for (int type = FLOAT16; type <= BFLOAT16; type++) {
+		ref_ptr<Grid3f> g = new Grid3f(reference);
+		g->setStorageType(gridStorageType(type));
+		EXPECT_EQ(type, g->getStorageType());
+		// relative precision of 11 and 8 bit mantissas
+		double eps = (type == FLOAT16) ? 1e-3 : 8e-3;
+		Vector3f bReduced = g->interpolate(pos);
+		EXPECT_NEAR(b.x, bReduced.x, eps * 4e-10);
+		EXPECT_NEAR(b.y, bReduced.y, eps * 4e-10);
+		EXPECT_NEAR(b.z, bReduced.z, eps * 4e-10);
+		EXPECT_NEAR(-1e-10, g->getValue(1, 1, 3).z, eps * 1e-10);
+#ifndef CRPROPA_TESTS_SKIP_EXCEPTIONS
+		EXPECT_THROW(g->get(1, 1, 1), std::runtime_error);
+#endif
+
+		// values are encoded on write, larger values rescale the grid
+		g->setValue(1, 1, 1, Vector3f(1, 2, 3) * 1e-11);
+		EXPECT_NEAR(2e-11, g->getValue(1, 1, 1).y, eps * 2e-11);
+		g->setValue(2, 2, 2, Vector3f(0, 0, -1e-5));
+		EXPECT_NEAR(-1e-5, g->getValue(2, 2, 2).z, eps * 1e-5);
+		EXPECT_NEAR(-1e-10, g->getValue(1, 1, 3).z, eps * 1e-10);
+		scaleGrid(g, 2);
+		EXPECT_NEAR(-2e-5, g->getValue(2, 2, 2).z, eps * 2e-5);
+
+		g->setStorageType(FLOAT32);
+		EXPECT_NEAR(-2e-10, g->get(1, 1, 3).z, eps * 2e-10);
+	}
+
+	// writing into a half precision grid of zeros
+	Grid1f zeros(Vector3d(0.), 4, 1);
+	zeros.setStorageType(FLOAT16);
+	zeros.setValue(1, 2, 3, 3e-12);
+	EXPECT_NEAR(3e-12, zeros.getValue(1, 2, 3), 1e-3 * 3e-12);
+	EXPECT_EQ(0, zeros.getValue(3, 2, 1));
+
+	// loading into a reduced precision grid
+	dumpGrid(grid, "testReduced.raw");
+	ref_ptr<Grid3f> loaded = new Grid3f(Vector3d(0.), 8, 1);
+	loaded->setStorageType(FLOAT16);
+	loadGrid(loaded, "testReduced.raw");
+	EXPECT_NEAR(-1e-10, loaded->getValue(1, 1, 3).z, 1e-3 * 1e-10);
+	EXPECT_NEAR(sin(5) * 1e-10, loaded->getValue(5, 1, 3).x, 1e-3 * 1e-10);
+	std::remove("testReduced.raw");
+
+#ifndef CRPROPA_TESTS_SKIP_EXCEPTIONS
+	Grid3d grid3d(Vector3d(0.), 2, 1);
+	EXPECT_THROW(grid3d.setStorageType(FLOAT16), std::runtime_error);
+#endif
+}
+
+TEST(Grid3f, BrickedLayout) {
+	// grid sizes that are not multiples of the brick size
+	GridProperties gp(Vector3d(0.), 5, 6, 9, 1.);
+	Grid3f grid(gp);
+	for (int ix = 0; ix < 5; ix++)
+		for (int iy = 0; iy < 6; iy++)
+			for (int iz = 0; iz < 9; iz++)
+				grid.get(ix, iy, iz) = Vector3f(ix, iy * iz, sin(ix + iy + iz));
+
+	gp.setLayout(BRICKED);
+	Grid3f bricked(gp);
+	EXPECT_EQ(BRICKED, bricked.getLayout());
+	for (int ix = 0; ix < 5; ix++)
+		for (int iy = 0; iy < 6; iy++)
+			for (int iz = 0; iz < 9; iz++)
+				bricked.get(ix, iy, iz) = grid.get(ix, iy, iz);
+
+	Grid3f converted(grid);
+	converted.setLayout(BRICKED);
+
+	for (int ipol = TRILINEAR; ipol <= NEAREST_NEIGHBOUR; ipol++) {
+#ifndef CRPROPA_HAVE_SSE
+		if (ipol == TRICUBIC)
+			continue;
+#endif
+		grid.setInterpolationType(interpolationType(ipol));
+		bricked.setInterpolationType(interpolationType(ipol));
+		converted.setInterpolationType(interpolationType(ipol));
+		for (int i = 0; i < 20; i++) {
+			// positions inside and outside of the grid
+			Vector3d pos(-3.3 + 0.7 * i, 0.45 * i, 11.1 - 0.9 * i);
+			EXPECT_EQ(grid.interpolate(pos), bricked.interpolate(pos));
+			EXPECT_EQ(grid.interpolate(pos), converted.interpolate(pos));
+		}
+	}
+
+	converted.setLayout(ROW_MAJOR);
+	EXPECT_EQ(grid.getGrid(), converted.getGrid());
+#ifndef CRPROPA_TESTS_SKIP_EXCEPTIONS
+	EXPECT_THROW(bricked.getGrid(), std::runtime_error);
+#endif
+}
+
+TEST(Grid3f, FromMagneticField) {
+	// sample a field at the cell centers, in parallel
+	ref_ptr<MagneticField> field = new MagneticDipoleField(Vector3d(0.), Vector3d(0, 0, 1), 1);
+	ref_ptr<Grid3f> grid = new Grid3f(Vector3d(-3.1, -2.9, -3.3), 7, 6, 5, 1.);
+	ref_ptr<Grid1f> strength = new Grid1f(Vector3d(-3.1, -2.9, -3.3), 7, 6, 5, 1.);
+	fromMagneticField(grid, field);
+	fromMagneticFieldStrength(strength, field);
+
+	for (int ix = 0; ix < 7; ix++)
+		for (int iy = 0; iy < 6; iy++)
+			for (int iz = 0; iz < 5; iz++) {
+				Vector3d pos = Vector3d(ix + 0.5, iy + 0.5, iz + 0.5) + grid->getOrigin();
+				Vector3d b = field->getField(pos);
+				EXPECT_EQ(Vector3f(b), grid->get(ix, iy, iz));
+				EXPECT_FLOAT_EQ(b.getR(), strength->get(ix, iy, iz));
+			}
+}
+
 TEST(Grid3f, Speed) {
 	// Dump and load a field grid
 	Grid3f grid(Vector3d(0.), 3, 3);
@@ -1049,6 +1436,50 @@ TEST(Grid3f, Speed) {
 		b = grid.interpolate(Vector3d(i));
 }
 
+// Benchmark of the interpolation for the grid layouts and storage types,
+// run with --gtest_also_run_disabled_tests
+TEST(Grid3f, DISABLED_InterpolationSpeed) {
+	const char *names[] = {"FLOAT32", "FLOAT16", "BFLOAT16"};
+	for (int layout = ROW_MAJOR; layout <= BRICKED; layout++) {
+		for (int type = FLOAT32; type <= BFLOAT16; type++) {
+			GridProperties gp(Vector3d(0.), 128, 1.);
+			gp.setLayout(gridLayoutType(layout));
+			Grid3f grid(gp);
+			for (int ix = 0; ix < 128; ix++)
+				for (int iy = 0; iy < 128; iy++)
+					for (int iz = 0; iz < 128; iz++)
+						grid.get(ix, iy, iz) = Vector3f(ix, iy, iz);
+			grid.setStorageType(gridStorageType(type));
+
+			// short trajectories and random positions
+			Random random(42);
+			std::vector<Vector3d> trajectories, positions;
+			for (int i = 0; i < 1000; i++) {
+				Vector3d pos = random.randVector() * 64 + Vector3d(64);
+				Vector3d step = random.randVector() * 0.3;
+				for (int j = 0; j < 1000; j++)
+					trajectories.push_back(pos + step * j);
+			}
+			for (int i = 0; i < 1000000; i++)
+				positions.push_back(Vector3d(random.rand(), random.rand(), random.rand()) * 128);
+
+			Vector3d b;
+			clock_t t0 = clock();
+			for (size_t i = 0; i < trajectories.size(); i++)
+				b += grid.interpolate(trajectories[i]);
+			clock_t t1 = clock();
+			for (size_t i = 0; i < positions.size(); i++)
+				b += grid.interpolate(positions[i]);
+			clock_t t2 = clock();
+			EXPECT_TRUE(b.x > 0);
+
+			std::cout << (layout == ROW_MAJOR ? "ROW_MAJOR " : "BRICKED   ") << names[type]
+				<< "\ttrajectories " << 1000. * (t1 - t0) / CLOCKS_PER_SEC << " ms"
+				<< "\trandom positions " << 1000. * (t2 - t1) / CLOCKS_PER_SEC << " ms" << std::endl;
+		}
+	}
+}
+
 TEST(CylindricalProjectionMap, functions) {
 	Vector3d v;
 	v.setRThetaPhi(1.0, 1.2, 2.4);
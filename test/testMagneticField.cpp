@@ -5,6 +5,9 @@
 #include "crpropa/magneticField/PolarizedSingleModeMagneticField.h"
 #include "crpropa/magneticField/GalacticMagneticField.h"
 #include "crpropa/magneticField/UF23Field.h"
+#include "crpropa/magneticField/JF12Field.h"
+#include "crpropa/magneticField/KST24Field.h"
+#include "crpropa/magneticField/TF17Field.h"
 #include "crpropa/Grid.h"
 #include "crpropa/Units.h"
 #include "crpropa/Common.h"
@@ -335,6 +338,34 @@ TEST(testUF23Field, SimpleTest) {
   }
 }
 
+TEST(testMagneticField, getFields) {
+	// batched evaluation agrees with evaluating single positions
+	ref_ptr<Grid3f> grid = new Grid3f(Vector3d(-10 * kpc), 4, 5 * kpc);
+	for (int ix = 0; ix < 4; ix++)
+		for (int iy = 0; iy < 4; iy++)
+			for (int iz = 0; iz < 4; iz++)
+				grid->get(ix, iy, iz) = Vector3f(ix, -iy, iz * iz) * muG;
+
+	std::vector<ref_ptr<MagneticField> > fields;
+	fields.push_back(new MagneticDipoleField(Vector3d(0.), Vector3d(0, 0, 1), 1 * kpc));
+	fields.push_back(new MagneticFieldGrid(grid));
+	fields.push_back(new JF12Field());
+	fields.push_back(new UF23Field(UF23Field::base));
+	fields.push_back(new TF17Field());
+	fields.push_back(new KST24Field());
+
+	std::vector<Vector3d> positions;
+	for (int i = 0; i < 9; i++)
+		positions.push_back(Vector3d(-8 + 1.5 * i, 3 - i, 0.2 * i - 1) * kpc);
+
+	for (size_t f = 0; f < fields.size(); f++) {
+		std::vector<Vector3d> b = fields[f]->getFields(positions);
+		ASSERT_EQ(b.size(), positions.size());
+		for (size_t i = 0; i < positions.size(); i++)
+			EXPECT_TRUE(b[i] == fields[f]->getField(positions[i]));
+	}
+}
+
 TEST(testPolarizedSingleModeMagneticField, SimpleTest) {
 	PolarizedSingleModeMagneticField B(2, 4, 0.5, Vector3d(1,1,1), Vector3d(0,1,0), Vector3d(1,0,0), "amplitude", "polarization", "elliptical");
 	Vector3d b = B.getField(Vector3d(1,1,2));
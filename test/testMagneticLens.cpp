@@ -9,6 +9,9 @@
 // Licensed under the GNU GPL v2             - 
 //--------------------------------------------
 
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <string>
 #include "gtest/gtest.h"
 
@@ -87,6 +90,93 @@ TEST(MagneticLens, Vector3Deflection)
 	EXPECT_NEAR(u.getAngleTo(v), 0., 2. / 180 * M_PI);
 }
 
+TEST(MagneticLens, transformCosmicRays)
+{
+	// each pixel is deflected to one of two pixels, a quarter of the cosmic
+	// rays is lost
+	MagneticLens magneticLens(3);
+	Pixelization P(3);
+	ModelMatrixType M;
+	M.resize(P.nPix(), P.nPix());
+	for (int i = 0; i < P.nPix(); i++)
+	{
+		M.insert((i + 1) % P.nPix(), i) = 0.25;
+		M.insert((i + 2) % P.nPix(), i) = 0.5;
+	}
+	magneticLens.setLensPart(M, 10 * EeV, 100 * EeV);
+
+	size_t n = 20000;
+	std::vector<double> phi(n), theta(n);
+	bool *survived = new bool[n];
+	for (size_t i = 0; i < n; i++)
+		P.pix2Direction(i % P.nPix(), phi[i], theta[i]);
+	size_t nSurvived = magneticLens.transformCosmicRays(20 * EeV, &phi[0], &theta[0], survived, n);
+	EXPECT_NEAR(nSurvived, 0.75 * n, 0.03 * n);
+
+	size_t nNext = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		int j = P.direction2Pix(phi[i], theta[i]);
+		int i0 = i % P.nPix();
+		if (!survived[i])
+			EXPECT_EQ(j, i0);
+		else if (j == (i0 + 1) % P.nPix())
+			nNext++;
+		else
+			EXPECT_EQ(j, (i0 + 2) % P.nPix());
+	}
+	EXPECT_NEAR(nNext, 0.25 * n, 0.03 * n);
+
+	// after normalizing the columns no cosmic ray is lost
+	magneticLens.normalizeMatrixColumns();
+	EXPECT_EQ(n, magneticLens.transformCosmicRays(20 * EeV, &phi[0], &theta[0], survived, n));
+
+	// changing the matrix requires an update of the column sums
+	ModelMatrixType &M2 = magneticLens.getLensPart(20 * EeV)->getMatrix();
+	M2.insert(0, 1) = 0.5;
+	EXPECT_THROW(magneticLens.transformCosmicRays(20 * EeV, &phi[0], &theta[0], survived, n), std::runtime_error);
+	magneticLens.getLensPart(20 * EeV)->updateColumnCDF();
+	magneticLens.transformCosmicRays(20 * EeV, &phi[0], &theta[0], survived, n);
+	delete[] survived;
+}
+
+TEST(MagneticLens, transformModelVectors)
+{
+	// batched transformation agrees with the product of the lens matrix
+	MagneticLens magneticLens(3);
+	Pixelization P(3);
+	ModelMatrixType M;
+	M.resize(P.nPix(), P.nPix());
+	for (int i = 0; i < P.nPix(); i++)
+	{
+		M.insert((i + 5) % P.nPix(), i) = 0.25;
+		M.insert((i * 3) % P.nPix(), i) += 0.5;
+	}
+	magneticLens.setLensPart(M, 10 * EeV, 100 * EeV);
+
+	size_t n = 19;
+	std::vector<double> models(n * P.nPix());
+	for (size_t i = 0; i < models.size(); i++)
+		models[i] = (i * 7919) % 101;
+	std::vector<double> expected(models.size());
+	for (size_t i = 0; i < n; i++)
+	{
+		Eigen::Map<Eigen::VectorXd> x(&models[i * P.nPix()], P.nPix());
+		Eigen::Map<Eigen::VectorXd> y(&expected[i * P.nPix()], P.nPix());
+		y = M * x;
+	}
+
+	magneticLens.transformModelVectors(&models[0], n, 20 * EeV);
+	for (size_t i = 0; i < models.size(); i++)
+		EXPECT_DOUBLE_EQ(expected[i], models[i]);
+
+	// single vectors
+	magneticLens.transformModelVector(&models[0], 20 * EeV);
+	magneticLens.transformModelVectors(&expected[0], 1, 20 * EeV);
+	for (size_t i = 0; i < P.nPix(); i++)
+		EXPECT_DOUBLE_EQ(expected[i], models[i]);
+}
+
 TEST(MagneticLens, OutOfBoundsEnergy)
 {
 	MagneticLens magneticLens(5);
@@ -100,6 +190,112 @@ TEST(MagneticLens, OutOfBoundsEnergy)
 }
 
 
+TEST(ModelMatrix, serializeCompressed)
+{
+	Pixelization P(2);
+	ModelMatrixType M;
+	M.resize(P.nPix(), P.nPix());
+	for (int i = 0; i < P.nPix(); i++)
+	{
+		M.insert((i * 7) % P.nPix(), i) = 0.5 + i;
+		M.insert((i * 3 + 1) % P.nPix(), i) += 0.25;
+	}
+	M.makeCompressed();
+
+	string oldFile = "ModelMatrix_serialize.mldat";
+	string newFile = "ModelMatrix_serializeCompressed.mldat";
+	serialize(oldFile, M);
+	serializeCompressed(newFile, M);
+
+	uint32_t rows, cols;
+	deserializeSize(newFile, rows, cols);
+	EXPECT_EQ(rows, P.nPix());
+	EXPECT_EQ(cols, P.nPix());
+	deserializeSize(oldFile, rows, cols);
+	EXPECT_EQ(rows, P.nPix());
+	EXPECT_EQ(cols, P.nPix());
+
+	ModelMatrixType A, B;
+	deserialize(oldFile, A);
+	deserialize(newFile, B);
+	ASSERT_EQ(A.nonZeros(), M.nonZeros());
+	ASSERT_EQ(B.nonZeros(), M.nonZeros());
+	for (int j = 0; j < M.outerSize(); j++)
+	{
+		for (ModelMatrixType::InnerIterator it(M, j); it; ++it)
+		{
+			EXPECT_EQ(A.coeff(it.row(), j), it.value());
+			EXPECT_EQ(B.coeff(it.row(), j), it.value());
+		}
+	}
+	// truncated files are rejected
+	std::ifstream in(newFile.c_str(), std::ios::binary);
+	std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	in.close();
+	std::ofstream out(newFile.c_str(), std::ios::binary);
+	out.write(content.data(), content.size() - 8);
+	out.close();
+	EXPECT_THROW(deserialize(newFile, B), std::runtime_error);
+
+	std::remove(oldFile.c_str());
+	std::remove(newFile.c_str());
+}
+
+TEST(MagneticLens, loadLensLazily)
+{
+	// the lens parts are only read when their rigidity range is used
+	Pixelization P(3);
+	ModelMatrixType M;
+	M.resize(P.nPix(), P.nPix());
+	for (int i = 0; i < P.nPix(); i++)
+		M.insert(i, i) = 1;
+	serializeCompressed("MagneticLens_part1.mldat", M);
+	serialize("MagneticLens_part2.mldat", M);
+	{
+		ofstream lensFile("MagneticLens_lens.txt");
+		lensFile << "# file log10(Rmin/V) log10(Rmax/V)\n";
+		lensFile << "MagneticLens_part1.mldat 18 19\n";
+		lensFile << "MagneticLens_part2.mldat 19 20\n";
+	}
+
+	MagneticLens magneticLens;
+	magneticLens.loadLens("MagneticLens_lens.txt");
+	ASSERT_EQ(magneticLens.getLensParts().size(), 2);
+	EXPECT_FALSE(magneticLens.getLensParts()[0]->isLoaded());
+	EXPECT_FALSE(magneticLens.getLensParts()[1]->isLoaded());
+
+	double phi = 0.3, theta = 0.2;
+	EXPECT_TRUE(magneticLens.transformCosmicRay(20 * EeV, phi, theta));
+	EXPECT_FALSE(magneticLens.getLensParts()[0]->isLoaded());
+	EXPECT_TRUE(magneticLens.getLensParts()[1]->isLoaded());
+	EXPECT_EQ(magneticLens.getLensParts()[0]->getMatrix().nonZeros(), P.nPix());
+	EXPECT_TRUE(magneticLens.getLensParts()[0]->isLoaded());
+
+	// a corrupt matrix is reported when it is first used, also from threads
+	std::ofstream("MagneticLens_part2.mldat", std::ios::binary | std::ios::app) << "x";
+	MagneticLens corruptLens;
+	corruptLens.loadLens("MagneticLens_lens.txt");
+	int nErrors = 0;
+#pragma omp parallel for reduction(+:nErrors)
+	for (int i = 0; i < 4; i++)
+	{
+		double phi = 0.3, theta = 0.2;
+		try
+		{
+			corruptLens.transformCosmicRay(20 * EeV, phi, theta);
+		}
+		catch (std::runtime_error &e)
+		{
+			nErrors++;
+		}
+	}
+	EXPECT_EQ(nErrors, 4);
+
+	std::remove("MagneticLens_part1.mldat");
+	std::remove("MagneticLens_part2.mldat");
+	std::remove("MagneticLens_lens.txt");
+}
+
 TEST(Pixelization, angularDistance)
 {
 	// test for correct angular distance in case of same vectors 
@@ -151,6 +347,48 @@ TEST(ParticleMapsContainer, getRandomParticles)
 
 }
 
+TEST(ParticleMapsContainer, randomParticleDistribution)
+{
+  // particles are drawn in proportion to the weights of maps and pixels
+  ParticleMapsContainer maps;
+  maps.addParticle(1000010010, 1 * EeV, 0, 0, 1);
+  maps.addParticle(1000020040, 1 * EeV, 0, 0, 1);
+  maps.addParticle(1000020040, 1 * EeV, M_PI / 2, 0, 2);
+  maps.addParticle(1000020040, 10 * EeV, 0, 0, 0);
+  EXPECT_DOUBLE_EQ(maps.getSumOfWeights(), 4);
+  EXPECT_DOUBLE_EQ(maps.getWeight(1000020040, 1 * EeV), 3);
+  EXPECT_DOUBLE_EQ(maps.getWeight(1000020040, 10 * EeV), 0);
+  EXPECT_DOUBLE_EQ(maps.getWeight(1000260560, 1 * EeV), 0);
+
+  double lon, lat;
+  EXPECT_FALSE(maps.placeOnMap(1000020040, 10 * EeV, lon, lat));
+  EXPECT_FALSE(maps.placeOnMap(1000260560, 1 * EeV, lon, lat));
+  EXPECT_TRUE(maps.placeOnMap(1000010010, 1 * EeV, lon, lat));
+
+  std::vector<double> energies, lons, lats;
+  std::vector<int> particleIds;
+  size_t N = 40000;
+  maps.getRandomParticles(N, particleIds, energies, lons, lats);
+
+  size_t nHelium = 0, nRotated = 0;
+  for (size_t i = 0; i < N; i++)
+  {
+    EXPECT_NEAR(log10(energies[i]), 18, 0.02);
+    if (particleIds[i] == 1000020040)
+      nHelium++;
+    if (fabs(lons[i] - M_PI / 2) < 2. / 180 * M_PI)
+      nRotated++;
+    else
+      EXPECT_NEAR(lons[i], 0, 2. / 180 * M_PI);
+  }
+  EXPECT_NEAR(nHelium, 0.75 * N, 0.02 * N);
+  EXPECT_NEAR(nRotated, 0.5 * N, 0.02 * N);
+
+  // weights are recalculated after adding particles
+  maps.addParticle(1000010010, 1 * EeV, 0, 0, 4);
+  EXPECT_DOUBLE_EQ(maps.getSumOfWeights(), 8);
+}
+
 TEST(Pixelization, randomDirectionInPixel)
 {
   Pixelization p(6);
@@ -3,9 +3,15 @@
 #include "crpropa/ParticleID.h"
 #include "crpropa/module/SimplePropagation.h"
 #include "crpropa/module/BreakCondition.h"
+#include "crpropa/module/ParticleCollector.h"
+#include "crpropa/Random.h"
 
 #include "gtest/gtest.h"
 
+#if _OPENMP
+#include <omp.h>
+#endif
+
 namespace crpropa {
 
 TEST(ModuleList, process) {
@@ -55,8 +61,151 @@ TEST(ModuleList, runSource) {
 	modules.run(&source, 100, false);
 }
 
+// splits each candidate at a random energy fraction down to 1 EeV
+class RandomSplitCascade: public Module {
+public:
+	void process(Candidate *candidate) const {
+		double E = candidate->current.getEnergy();
+		if (E > 1 * EeV) {
+			double f = Random::instance().rand();
+			candidate->addSecondary(candidate->current.getId(), f * E);
+			candidate->addSecondary(candidate->current.getId(), (1 - f) * E);
+		}
+		candidate->setActive(false);
+	}
+};
+
+TEST(ModuleList, runSourceStreams) {
+	Source source;
+	source.add(new SourceIsotropicEmission());
+	source.add(new SourcePowerLawSpectrum(5 * EeV, 100 * EeV, -2));
+	source.add(new SourceParticleType(nucleusId(1, 1)));
+
+#if _OPENMP
+	int maxThreads = omp_get_max_threads();
+	int nThreads[2] = {1, 4};
+#endif
+	Random::enableStreams(1234);
+	std::vector<double> energies[2];
+	for (int n = 0; n < 2; n++) {
+		// reseed to make sure only the streams determine the result
+		Random::seedThreads(n);
+#if _OPENMP
+		omp_set_num_threads(nThreads[n]);
+#endif
+		ref_ptr<ParticleCollector> collector = new ParticleCollector();
+		ModuleList modules;
+		modules.add(new SimplePropagation());
+		modules.add(new RandomSplitCascade());
+		modules.add(collector);
+		modules.run(&source, 100);
+		for (size_t i = 0; i < collector->size(); i++)
+			energies[n].push_back((*collector)[i]->current.getEnergy());
+		std::sort(energies[n].begin(), energies[n].end());
+	}
+	Random::disableStreams();
+#if _OPENMP
+	omp_set_num_threads(maxThreads);
+#endif
+
+	// the cascades contain secondaries
+	EXPECT_GT(energies[0].size(), 100);
+	EXPECT_TRUE(energies[0] == energies[1]);
+}
+
+TEST(ModuleList, runSourceStreamsConsecutive) {
+	// consecutive runs continue with new streams
+	Source source;
+	source.add(new SourcePowerLawSpectrum(5 * EeV, 100 * EeV, -2));
+	source.add(new SourceParticleType(nucleusId(1, 1)));
+
+	Random::enableStreams(1234);
+	ref_ptr<ParticleCollector> collector = new ParticleCollector();
+	ModuleList modules;
+	modules.add(new MaximumTrajectoryLength(0));
+	modules.add(collector);
+	std::vector<double> energies[2];
+	for (int n = 0; n < 2; n++) {
+		collector->clearContainer();
+		modules.run(&source, 100, false);
+		for (size_t i = 0; i < collector->size(); i++)
+			energies[n].push_back((*collector)[i]->current.getEnergy());
+		std::sort(energies[n].begin(), energies[n].end());
+	}
+	EXPECT_EQ(modules.getPrimaryStreamOffset(), 200);
+
+	// restarting at the same offset reproduces the second run
+	collector->clearContainer();
+	modules.setPrimaryStreamOffset(100);
+	modules.run(&source, 100, false);
+	std::vector<double> repeated;
+	for (size_t i = 0; i < collector->size(); i++)
+		repeated.push_back((*collector)[i]->current.getEnergy());
+	std::sort(repeated.begin(), repeated.end());
+	Random::disableStreams();
+
+	EXPECT_EQ(energies[0].size(), 100);
+	EXPECT_FALSE(energies[0] == energies[1]);
+	EXPECT_TRUE(repeated == energies[1]);
+}
+
+// splits each candidate into two secondaries of half the energy down to 1 EeV
+class SplitCascade: public Module {
+public:
+	void process(Candidate *candidate) const {
+		double E = candidate->current.getEnergy();
+		if (E > 1 * EeV) {
+			candidate->addSecondary(candidate->current.getId(), E / 2);
+			candidate->addSecondary(candidate->current.getId(), E / 2);
+		}
+		candidate->setActive(false);
+	}
+};
+
+TEST(ModuleList, runSecondaryTasks) {
+	Source source;
+	source.add(new SourceParticleType(nucleusId(1, 1)));
+	source.add(new SourceEnergy(64 * EeV));
+
+	ref_ptr<ParticleCollector> collector = new ParticleCollector();
+	ModuleList modules;
+	modules.add(new SplitCascade());
+	modules.add(collector);
+	modules.setSecondaryTasks(true);
+	EXPECT_TRUE(modules.getSecondaryTasks());
+#if _OPENMP
+	int maxThreads = omp_get_max_threads();
+	omp_set_num_threads(2);
+#endif
+	modules.run(&source, 10);
+#if _OPENMP
+	omp_set_num_threads(maxThreads);
+#endif
+
+	// 10 cascades of 1 + 2 + ... + 64 candidates
+	EXPECT_EQ(collector->size(), 10 * 127);
+}
+
+TEST(ModuleList, runReleaseSecondaries) {
+	ref_ptr<ParticleCollector> collector = new ParticleCollector();
+	ModuleList modules;
+	modules.add(new SplitCascade());
+	modules.add(collector);
+
+	ref_ptr<Candidate> c1 = new Candidate(nucleusId(1, 1), 64 * EeV);
+	modules.run(c1);
+	EXPECT_EQ(collector->size(), 127);
+	EXPECT_EQ(c1->secondaries.size(), 2);
+
+	modules.setReleaseSecondaries(true);
+	EXPECT_TRUE(modules.getReleaseSecondaries());
+	ref_ptr<Candidate> c2 = new Candidate(nucleusId(1, 1), 64 * EeV);
+	modules.run(c2);
+	EXPECT_EQ(collector->size(), 2 * 127);
+	EXPECT_EQ(c2->secondaries.size(), 0);
+}
+
 #if _OPENMP
-#include <omp.h>
 TEST(ModuleList, runOpenMP) {
 	ModuleList modules;
 	modules.add(new SimplePropagation());
@@ -66,8 +215,10 @@ TEST(ModuleList, runOpenMP) {
 	source.add(new SourceIsotropicEmission());
 	source.add(new SourcePowerLawSpectrum(5 * EeV, 100 * EeV, -2));
 	source.add(new SourceParticleType(nucleusId(1, 1)));
+	int maxThreads = omp_get_max_threads();
 	omp_set_num_threads(2);
 	modules.run(&source, 1000, false);
+	omp_set_num_threads(maxThreads);
 }
 #endif
 
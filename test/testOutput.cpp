@@ -8,6 +8,7 @@
 
 #include "gtest/gtest.h"
 #include <iostream>
+#include <sstream>
 #include <string>
 
 
@@ -138,6 +139,39 @@ TEST(TextOutput, printHeader_Version) {
 	          g_GIT_DESC);
 }
 
+TEST(TextOutput, threadBuffer) {
+	Candidate c;
+	std::stringstream ss;
+	TextOutput output(ss, Output::Event1D);
+	output.setThreadBufferSize(10);
+
+	// outside of a parallel region the rows are written directly
+	for (int i = 0; i < 25; i++)
+		output.process(&c);
+	EXPECT_EQ(output.size(), 25);
+
+#ifdef _OPENMP
+	// the last 5 rows of each thread are still held in the thread buffers
+#pragma omp parallel for schedule(static) num_threads(2)
+	for (int i = 0; i < 50; i++)
+		output.process(&c);
+	EXPECT_EQ(output.size(), 65);
+#else
+	for (int i = 0; i < 50; i++)
+		output.process(&c);
+#endif
+
+	output.close();
+	EXPECT_EQ(output.size(), 75);
+
+	size_t rows = 0;
+	std::string line;
+	while (std::getline(ss, line))
+		if (line[0] != '#')
+			rows++;
+	EXPECT_EQ(rows, 75);
+}
+
 #ifndef CRPROPA_TESTS_SKIP_EXCEPTIONS
 TEST(TextOutput, failOnIllegalOutputFile) {
 	EXPECT_THROW(
@@ -156,6 +190,81 @@ TEST(HDF5Output, failOnIllegalOutputFile) {
 	             std::runtime_error);
 }
 #endif
+
+TEST(HDF5Output, asyncWrite) {
+	std::string filename = "HDF5Output_asyncWrite.h5";
+	size_t n = 100000;
+	{
+		HDF5Output out(filename, Output::Event1D);
+		out.setAsyncWrite(true);
+		EXPECT_TRUE(out.isAsyncWrite());
+		Candidate c;
+		for (size_t i = 0; i < n; i++)
+			out.process(&c);
+		out.close();
+	}
+
+	hid_t file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+	hid_t dset = H5Dopen2(file, "CRPROPA3", H5P_DEFAULT);
+	hid_t space = H5Dget_space(dset);
+	EXPECT_EQ(H5Sget_simple_extent_npoints(space), n);
+	H5Sclose(space);
+	H5Dclose(dset);
+	H5Fclose(file);
+	std::remove(filename.c_str());
+}
+
+TEST(HDF5Output, concurrentOutputs) {
+	// an asynchronous and a synchronous output write at the same time
+	std::string filename[2] = {"HDF5Output_concurrent0.h5", "HDF5Output_concurrent1.h5"};
+	long n = 5000;
+	{
+		HDF5Output out0(filename[0], Output::Event1D);
+		HDF5Output out1(filename[1], Output::Event1D);
+		out0.setAsyncWrite(true);
+		out0.setFlushLimit(500);
+		out1.setFlushLimit(500);
+		#pragma omp parallel for
+		for (long i = 0; i < n; i++) {
+			Candidate c;
+			out0.process(&c);
+			out1.process(&c);
+		}
+		out0.close();
+		out1.close();
+	}
+
+	for (int i = 0; i < 2; i++) {
+		hid_t file = H5Fopen(filename[i].c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+		hid_t dset = H5Dopen2(file, "CRPROPA3", H5P_DEFAULT);
+		hid_t space = H5Dget_space(dset);
+		EXPECT_EQ(H5Sget_simple_extent_npoints(space), n);
+		H5Sclose(space);
+		H5Dclose(dset);
+		H5Fclose(file);
+		std::remove(filename[i].c_str());
+	}
+}
+
+TEST(HDF5Output, threadBuffer) {
+	std::string filename = "HDF5Output_threadBuffer.h5";
+	HDF5Output out(filename, Output::Event1D);
+	out.setThreadBufferSize(100);
+	Candidate c;
+#ifdef _OPENMP
+	// the last 25 rows of each thread are still held in the thread buffers
+#pragma omp parallel for schedule(static) num_threads(2)
+	for (int i = 0; i < 1050; i++)
+		out.process(&c);
+	EXPECT_EQ(out.size(), 1000);
+#else
+	for (int i = 0; i < 1050; i++)
+		out.process(&c);
+#endif
+	out.close();
+	EXPECT_EQ(out.size(), 1050);
+	std::remove(filename.c_str());
+}
 #endif
 
 //-- ParticleCollector
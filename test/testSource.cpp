@@ -1,8 +1,10 @@
 #include "crpropa/Source.h"
+#include "crpropa/GridTools.h"
 #include "crpropa/Units.h"
 #include "crpropa/ParticleID.h"
 
 #include "gtest/gtest.h"
+#include <cstdio>
 #include <stdexcept>
 
 namespace crpropa {
@@ -180,6 +182,37 @@ TEST(SourceDensityGrid, OneAllowedCell) {
 	EXPECT_NEAR(1, mean.z, 0.2);
 }
 
+TEST(SourceDensityGrid, storageVariants) {
+	// bricked, half precision and memory-mapped density grids
+	GridProperties gp(Vector3d(0.), 5, 6, 3, 1.);
+	ref_ptr<Grid1f> grid = new Grid1f(gp);
+	grid->get(3, 4, 1) = 1;
+	dumpGridBinary(grid, "testSourceDensity.grid");
+
+	std::vector<ref_ptr<Grid1f> > grids;
+	grids.push_back(new Grid1f(*grid));
+	grids[0]->setLayout(BRICKED);
+	grids.push_back(new Grid1f(*grid));
+	grids[1]->setStorageType(FLOAT16);
+	grids.push_back(mapGrid1f("testSourceDensity.grid"));
+
+	for (size_t i = 0; i < grids.size(); i++) {
+		SourceDensityGrid source(grids[i]);
+		ParticleState p;
+		for (int j = 0; j < 100; j++) {
+			source.prepareParticle(p);
+			Vector3d pos = p.getPosition();
+			EXPECT_LE(3, pos.x);
+			EXPECT_GE(4, pos.x);
+			EXPECT_LE(4, pos.y);
+			EXPECT_GE(5, pos.y);
+			EXPECT_LE(1, pos.z);
+			EXPECT_GE(2, pos.z);
+		}
+	}
+	std::remove("testSourceDensity.grid");
+}
+
 TEST(SourceDensityGrid1D, withInRange) {
 	// Create a grid with 10 cells ranging from 0 to 10
 	Vector3d origin(0, 0, 0);
@@ -218,6 +251,10 @@ TEST(SourceDensityGrid1D, OneAllowedCell) {
 	SourceDensityGrid1D source(grid);
 	ParticleState p;
 
+	// the density grid is left unchanged
+	EXPECT_EQ(1, grid->getValue(5, 0, 0));
+	EXPECT_EQ(0, grid->getValue(6, 0, 0));
+
 	for (int i = 0; i < 100; i++) {
 		source.prepareParticle(p);
 		// dialed position should be in range 5-6
@@ -227,6 +264,42 @@ TEST(SourceDensityGrid1D, OneAllowedCell) {
 	}
 }
 
+// thin disk with exponential profile in z
+class ExponentialDiskDensity: public Density {
+public:
+	double getDensity(const Vector3d &position) const {
+		return exp(-fabs(position.z) / (0.1 * kpc));
+	}
+};
+
+TEST(SourceMassDistribution, samplingGrid) {
+	// positions drawn from the tabulated density follow the z-profile
+	SourceMassDistribution source(new ExponentialDiskDensity(), 1);
+	source.setSamplingGrid(10, 10, 80);
+	source.setZrange(-1 * kpc, 1 * kpc);
+
+	size_t n = 10000;
+	size_t nInner = 0;
+	for (size_t i = 0; i < n; i++) {
+		Vector3d pos = source.samplePosition();
+		EXPECT_LE(-20 * kpc, pos.x);
+		EXPECT_GE(20 * kpc, pos.x);
+		EXPECT_LE(-20 * kpc, pos.y);
+		EXPECT_GE(20 * kpc, pos.y);
+		EXPECT_LE(-1 * kpc, pos.z);
+		EXPECT_GE(1 * kpc, pos.z);
+		if (fabs(pos.z) < 0.1 * kpc)
+			nInner++;
+	}
+	// 1 - exp(-1) of the sources within one scale height
+	EXPECT_NEAR(nInner, (1 - exp(-1)) / (1 - exp(-10)) * n, 0.02 * n);
+
+	// back to rejection sampling
+	source.setSamplingGrid(0, 0, 0);
+	Vector3d pos = source.samplePosition();
+	EXPECT_GE(1 * kpc, fabs(pos.z));
+}
+
 TEST(SourcePowerLawSpectrum, simpleTest) {
 	double Emin = 4 * EeV;
 	double Emax = 200 * EeV;
@@ -39,6 +39,46 @@ TEST(testTurbulenceSpectrum, correlationLength) {
     EXPECT_NEAR(Lc, 0.498*lBo, 0.001*lBo);
 }
 
+TEST(testPlaneWaveTurbulence, simdLevel) {
+	// the SIMD kernels agree with the scalar implementation near the origin
+	auto spectrum = TurbulenceSpectrum(1 * muG, 10 * kpc, 1 * Mpc);
+	SimdLevel maxLevel = getMaximumSimdLevel();
+	setMaximumSimdLevel(SIMD_NONE);
+	PlaneWaveTurbulence scalar(spectrum, 50, 137);
+
+	for (int level = SIMD_AVX; level <= SIMD_AVX512; level++) {
+		setMaximumSimdLevel(SimdLevel(level));
+		EXPECT_LE(getSimdLevel(), cpuSimdLevel());
+		PlaneWaveTurbulence fast(spectrum, 50, 137);
+		for (int i = 0; i < 10; i++) {
+			Vector3d pos(0.1 * i * kpc, -0.2 * i * kpc, 0.3 * i * kpc);
+			Vector3d b = scalar.getField(pos);
+			EXPECT_NEAR(b.x, fast.getField(pos).x, 1e-6 * muG);
+			EXPECT_NEAR(b.y, fast.getField(pos).y, 1e-6 * muG);
+			EXPECT_NEAR(b.z, fast.getField(pos).z, 1e-6 * muG);
+		}
+	}
+	setMaximumSimdLevel(maxLevel);
+}
+
+TEST(testPlaneWaveTurbulence, getFields) {
+	// batched evaluation gives the same values as single positions
+	auto spectrum = TurbulenceSpectrum(1 * muG, 10 * kpc, 1 * Mpc);
+	PlaneWaveTurbulence field(spectrum, 37, 137);
+
+	std::vector<Vector3d> positions;
+	for (int i = 0; i < 7; i++)
+		positions.push_back(Vector3d(1.1 * i, -0.7 * i, 0.3 * i * i) * kpc);
+	std::vector<Vector3d> fields = field.getFields(positions);
+	ASSERT_EQ(fields.size(), positions.size());
+	for (size_t i = 0; i < positions.size(); i++) {
+		Vector3d b = field.getField(positions[i]);
+		EXPECT_NEAR(b.x, fields[i].x, 1e-12 * muG);
+		EXPECT_NEAR(b.y, fields[i].y, 1e-12 * muG);
+		EXPECT_NEAR(b.z, fields[i].z, 1e-12 * muG);
+	}
+}
+
 #ifdef CRPROPA_HAVE_FFTW3F
 
 TEST(testSimpleGridTurbulence, oldFunctionForCrrelationLength) { //TODO: remove in future
@@ -134,6 +174,32 @@ TEST(testGridTurbulence, Turbulence_seed) {
 	Vector3d pos(22 * Mpc);
 	EXPECT_FLOAT_EQ(tf1.getField(pos).x, tf2.getField(pos).x);
 }
+
+TEST(testGridTurbulence, threadsAndWisdom) {
+	// threaded and optimized transforms produce the same field
+	size_t n = 32;
+	double spacing = 1 * Mpc;
+	double lMax = 8 * spacing;
+	auto spectrum = TurbulenceSpectrum(1, 2 * spacing, lMax, lMax / 6);
+	auto gp = GridProperties(Vector3d(0, 0, 0), n, spacing);
+	auto tf1 = GridTurbulence(spectrum, gp, 137);
+
+	std::string wisdom = "GridTurbulence_wisdom.txt";
+	GridTurbulence::setFFTThreads(2);
+	GridTurbulence::setFFTWisdomFile(wisdom);
+	auto tf2 = GridTurbulence(spectrum, gp, 137);
+	auto tf3 = GridTurbulence(spectrum, gp, 137); // plan from wisdom
+	GridTurbulence::setFFTThreads(0);
+	GridTurbulence::setFFTWisdomFile("");
+	std::remove(wisdom.c_str());
+
+	Vector3d pos(5.5 * Mpc, 7.2 * Mpc, 1.3 * Mpc);
+	Vector3d b1 = tf1.getField(pos);
+	EXPECT_GT(b1.getR(), 0);
+	EXPECT_NEAR(b1.x, tf2.getField(pos).x, 1e-5);
+	EXPECT_NEAR(b1.y, tf2.getField(pos).y, 1e-5);
+	EXPECT_NEAR(b1.z, tf3.getField(pos).z, 1e-5);
+}
 #endif // CRPROPA_HAVE_FFTW3F
 
 int main(int argc, char **argv) {